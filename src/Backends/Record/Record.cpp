@@ -0,0 +1,303 @@
+#include "Record.hpp"
+#include "Core/Recording.hpp"
+#include "Core/EventCodec.h"
+#include "Utils/PrismLog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using PrismLog::fatal;
+using PrismLog::info;
+
+namespace
+{
+
+constexpr size_t chunkBytes = 8UL << 20;
+
+std::string outputPath{"."};
+bool compress{true};
+/* options */
+
+std::atomic<unsigned> streams{0};
+std::atomic<unsigned long long> totalEvents{0};
+std::atomic<unsigned long long> totalBlocks{0};
+std::atomic<unsigned long long> totalBytes{0};
+
+auto isNamed(const PrismEvVariant &ev) -> bool
+{
+    return ev.tag == PRISM_CXT_TAG &&
+           (ev.cxt.type == PRISM_CXT_FUNC_ENTER || ev.cxt.type == PRISM_CXT_FUNC_EXIT);
+}
+
+}; //end namespace
+
+
+namespace Record
+{
+
+//-----------------------------------------------------------------------------
+/** Writer **/
+Writer::Writer(const std::string &path)
+    : chunk(chunkBytes)
+    , pending(chunkBytes)
+{
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        fatal("record: could not open " + path + " -- " + strerror(errno));
+
+    writer = std::thread(&Writer::writeLoop, this);
+}
+
+
+Writer::~Writer()
+{
+    if (fill > 0)
+        handOff();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [&]{ return pendingFull == false; });
+        done = true;
+        cond.notify_all();
+    }
+
+    writer.join();
+    close(fd);
+}
+
+
+auto Writer::append(const void *data, size_t bytes) -> void
+{
+    auto src = static_cast<const char*>(data);
+    while (bytes > 0)
+    {
+        auto n = std::min(bytes, chunk.size() - fill);
+        std::memcpy(chunk.data() + fill, src, n);
+        fill += n;
+        src += n;
+        bytes -= n;
+
+        if (fill == chunk.size())
+            handOff();
+    }
+}
+
+
+auto Writer::align(uint64_t alignment) -> void
+{
+    static const char zeros[prism::recordAlign] = {};
+    assert(alignment <= sizeof(zeros));
+    append(zeros, ((offset() + alignment - 1) & ~(alignment - 1)) - offset());
+}
+
+
+auto Writer::handOff() -> void
+{
+    /* wait for the writer to finish the previous chunk */
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [&]{ return pendingFull == false; });
+
+    std::swap(chunk, pending);
+    pendingFill = fill;
+    pendingFull = true;
+    written += fill;
+    fill = 0;
+    cond.notify_all();
+}
+
+
+auto Writer::writeLoop() -> void
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait(lock, [&]{ return pendingFull || done; });
+            if (pendingFull == false)
+                return;
+        }
+
+        size_t off = 0;
+        while (off < pendingFill)
+        {
+            auto ret = write(fd, pending.data() + off, pendingFill - off);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret < 0)
+                fatal(std::string("record: write failed -- ") + strerror(errno));
+            off += ret;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        pendingFull = false;
+        cond.notify_all();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** Handler **/
+Handler::Handler()
+    : out(outputPath + "/" + prism::recordFilePrefix + std::to_string(streams++))
+{
+    prism::RecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, prism::recordMagic, sizeof(header.magic));
+    header.version = prism::recordVersion;
+    out.append(&header, sizeof(header));
+}
+
+
+Handler::~Handler()
+{
+    prism::RecordFooter footer;
+    std::memset(&footer, 0, sizeof(footer));
+    footer.indexOffset = out.offset();
+    footer.blocks = index.size();
+    footer.events = events;
+    std::memcpy(footer.magic, prism::recordMagic, sizeof(footer.magic));
+
+    out.append(index.data(), index.size() * sizeof(uint64_t));
+    out.append(&footer, sizeof(footer));
+
+    totalEvents += events;
+    totalBlocks += index.size();
+    totalBytes += out.offset();
+}
+
+
+auto Handler::onEvents(const EventBuffer &buf, const GetNameBase &nameBase) -> void
+{
+    if (buf.used == 0)
+        return;
+
+    const EventBuffer *image = packed(buf);
+
+    /* only keep the names this buffer refers to */
+    uint64_t nameBytes = 0;
+    for (decltype(image->used) i = 0; i < image->used; ++i)
+        if (isNamed(image->events[i]))
+            nameBytes = std::max<uint64_t>(nameBytes, image->events[i].cxt.idx +
+                                                      image->events[i].cxt.len);
+
+    if (compress == true)
+        image = compact(*image);
+
+    EventBuffer trimmed;
+    trimmed.used     = image->used;
+    trimmed.encoding = image->encoding;
+    trimmed.capacity = image->encoding == PRISM_EVENTS_COMPACT ? image->capacity : image->used;
+    auto eventBytes = prismEventBufferSize(trimmed.encoding, trimmed.capacity);
+
+    prism::RecordBlock block;
+    std::memset(&block, 0, sizeof(block));
+    block.eventBytes = eventBytes;
+    block.nameBytes = nameBytes;
+
+    index.push_back(out.offset());
+    out.append(&block, sizeof(block));
+    out.append(&trimmed, sizeof(EventBuffer));
+    out.append(image->events, eventBytes - sizeof(EventBuffer));
+    out.align(prism::recordAlign);
+    if (nameBytes > 0)
+    {
+        out.append(nameBase(), nameBytes);
+        out.align(prism::recordAlign);
+    }
+
+    events += buf.used;
+}
+
+
+auto Handler::packed(const EventBuffer &buf) -> const EventBuffer*
+{
+    if (buf.encoding != PRISM_EVENTS_COLUMNS)
+        return &buf;
+
+    unpacked.resize(prismEventBufferSize(PRISM_EVENTS_PACKED, buf.used));
+    auto dst = reinterpret_cast<EventBuffer*>(unpacked.data());
+    prismColumnsUnpack(dst, &buf);
+    return dst;
+}
+
+
+auto Handler::compact(const EventBuffer &buf) -> const EventBuffer*
+{
+    /* Encode with the shared memory codec. The capacity of the result
+     * is trimmed to the encoded length, rounded up to whole events.
+     * Falls back to 'buf' if the events do not get any smaller */
+
+    const uint32_t room = buf.used * 2 + 1;
+    encoded.resize(prismEventBufferSize(PRISM_EVENTS_COMPACT, room));
+    auto dst = reinterpret_cast<EventBuffer*>(encoded.data());
+    dst->encoding = PRISM_EVENTS_COMPACT;
+    dst->capacity = room;
+
+    PrismEncoder enc;
+    prismEncoderInit(&enc, dst);
+    for (decltype(buf.used) i = 0; i < buf.used; ++i)
+    {
+        if (prismEncoderFull(&enc))
+            return &buf;
+        prismEncodeEvent(&enc, &buf.events[i]);
+    }
+    prismEncoderFinish(&enc);
+
+    auto bytes = sizeof(CompactEvents) + prismCompact(dst)->bytes;
+    dst->capacity = (bytes + sizeof(PrismEvVariant) - 1) / sizeof(PrismEvVariant);
+    if (dst->capacity >= buf.used)
+        return &buf;
+
+    return dst;
+}
+
+
+//-----------------------------------------------------------------------------
+/** Prism hooks **/
+auto onParse(Args args) -> void
+{
+    /* -o OUTPUT_DIRECTORY
+     * -c {compact,none} */
+    for (auto arg = args.cbegin(); arg != args.cend(); ++arg)
+    {
+        if ((*arg != "-o" && *arg != "-c") || arg + 1 == args.cend())
+            fatal("unexpected record options");
+
+        auto opt = *arg;
+        auto val = *(++arg);
+        if (opt == "-o")
+            outputPath = val;
+        else if (val == "compact")
+            compress = true;
+        else if (val == "none")
+            compress = false;
+        else
+            fatal("unexpected record options: -c " + val);
+    }
+
+    struct stat info;
+    if (stat(outputPath.c_str(), &info) != 0 || S_ISDIR(info.st_mode) == false)
+        fatal("record: output directory not found: " + outputPath);
+
+    /* handlers created from now on record streams 0, 1, ... */
+    streams = 0;
+}
+
+
+auto onExit() -> void
+{
+    info("record     : {} events in {} buffers to {}/{}*",
+         totalEvents, totalBlocks, outputPath, prism::recordFilePrefix);
+    info("record     : {:.1f} MB, {:.2f} bytes/event",
+         totalBytes / 1e6, totalEvents > 0 ? double(totalBytes) / totalEvents : 0.0);
+}
+
+
+auto requirements() -> prism::capabilities
+{
+    return prism::recordCapabilities();
+}
+
+}; //end namespace Record
@@ -0,0 +1,76 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "Core/Backends.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Record
+{
+
+auto onParse(Args args) -> void;
+auto onExit() -> void;
+auto requirements() -> prism::capabilities;
+/* Prism hooks */
+
+class Writer
+{
+    /* Appends to a file from a separate thread.
+     * The backend thread only copies into the current chunk;
+     * full chunks are written out with large sequential writes
+     * while the next chunk fills up */
+
+  public:
+    Writer(const std::string &path);
+    ~Writer();
+
+    auto append(const void *data, size_t bytes) -> void;
+    auto align(uint64_t alignment) -> void;
+    auto offset() const -> uint64_t { return written + fill; }
+
+  private:
+    auto handOff() -> void;
+    auto writeLoop() -> void;
+
+    int fd;
+    std::vector<char> chunk, pending;
+    size_t fill{0}, pendingFill{0};
+    uint64_t written{0};
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool pendingFull{false};
+    bool done{false};
+    std::thread writer;
+};
+
+class Handler : public BackendIface
+{
+    /* Records every buffer it receives, see Core/Recording.hpp */
+
+  public:
+    Handler();
+    Handler(const Handler &) = delete;
+    Handler &operator=(const Handler &) = delete;
+    virtual ~Handler() override;
+
+    virtual auto onEvents(const EventBuffer &buf,
+                          const GetNameBase &nameBase) -> void override;
+
+  private:
+    auto packed(const EventBuffer &buf) -> const EventBuffer*;
+    auto compact(const EventBuffer &buf) -> const EventBuffer*;
+
+    Writer out;
+    std::vector<uint64_t> index;
+    unsigned long long events{0};
+
+    std::vector<char> unpacked, encoded;
+    /* scratch buffers */
+};
+
+}; //end namespace Record
+
+#endif
@@ -0,0 +1,172 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Backends/Record/Record.hpp"
+#include "Frontends/Replay/ReplayFrontend.hpp"
+
+decltype(FrontendIface::uidCount) FrontendIface::uidCount{0};
+
+
+struct TestBuffer
+{
+    std::vector<uint64_t> storage;
+
+    TestBuffer(uint32_t capacity)
+        : storage(prismEventBufferSize(PRISM_EVENTS_PACKED, capacity) / sizeof(uint64_t) + 1)
+    {
+        get()->used     = 0;
+        get()->encoding = PRISM_EVENTS_PACKED;
+        get()->capacity = capacity;
+    }
+
+    auto get() -> EventBuffer* { return reinterpret_cast<EventBuffer*>(storage.data()); }
+};
+
+
+auto fill(EventBuffer *buf, unsigned seed) -> void
+{
+    /* a bit of everything, including one named context event */
+    for (unsigned i = 0; i < buf->capacity; ++i)
+    {
+        PrismEvVariant &ev = buf->events[i];
+        memset(&ev, 0, sizeof(ev));
+        switch ((i + seed) % 4)
+        {
+        case 0:
+            ev.tag = PRISM_MEM_TAG;
+            ev.mem.type = PRISM_MEM_STORE;
+            ev.mem.begin_addr = 0x7fff0000 + (PtrVal)(i + seed) * 8;
+            ev.mem.size = 8;
+            break;
+        case 1:
+            ev.tag = PRISM_COMP_TAG;
+            ev.comp.type = PRISM_COMP_FLOP;
+            ev.comp.arity = PRISM_COMP_BINARY;
+            ev.comp.op = PRISM_COMP_MULT;
+            ev.comp.size = 4;
+            break;
+        case 2:
+            ev.tag = PRISM_SYNC_TAG;
+            ev.sync.type = PRISM_SYNC_LOCK;
+            ev.sync.data[0] = 0x1000 + seed;
+            break;
+        case 3:
+            ev.tag = PRISM_CXT_TAG;
+            ev.cxt.type = PRISM_CXT_INSTR;
+            ev.cxt.id = 0x400000 + (PtrVal)i * 4;
+            break;
+        }
+    }
+
+    PrismEvVariant &named = buf->events[buf->capacity / 2];
+    named.tag = PRISM_CXT_TAG;
+    named.cxt.type = PRISM_CXT_FUNC_ENTER;
+    named.cxt.idx = 4;
+    named.cxt.len = 5;
+
+    buf->used = buf->capacity;
+}
+
+
+auto same(const PrismEvVariant &a, const PrismEvVariant &b) -> bool
+{
+    /* compare the fields only, the compact encoding does not keep padding */
+    if (a.tag != b.tag)
+        return false;
+
+    switch (a.tag)
+    {
+    case PRISM_MEM_TAG:
+        return a.mem.type == b.mem.type && a.mem.begin_addr == b.mem.begin_addr &&
+               a.mem.size == b.mem.size;
+    case PRISM_COMP_TAG:
+        return a.comp.type == b.comp.type && a.comp.arity == b.comp.arity &&
+               a.comp.op == b.comp.op && a.comp.size == b.comp.size;
+    case PRISM_SYNC_TAG:
+        return a.sync.type == b.sync.type && a.sync.data[0] == b.sync.data[0] &&
+               a.sync.data[1] == b.sync.data[1];
+    case PRISM_CXT_TAG:
+        return a.cxt.type == b.cxt.type && a.cxt.id == b.cxt.id;
+    default:
+        return false;
+    }
+}
+
+
+auto roundTrip(const std::string &compression) -> void
+{
+    char dir[] = "/tmp/prism-record-test-XXXXXX";
+    REQUIRE(mkdtemp(dir) != nullptr);
+    Record::onParse({"-o", dir, "-c", compression});
+
+    const char names[] = "xxx\0main";
+    GetNameBase nameBase = [&]{ return names; };
+
+    std::vector<TestBuffer> recorded;
+    {
+        Record::Handler record;
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            recorded.emplace_back(100 + i);
+            fill(recorded.back().get(), i);
+            record.onEvents(*recorded.back().get(), nameBase);
+        }
+    }
+
+    auto generator = startReplay({dir}, {}, 1, replayCapabilities(), IpcConfig{});
+    auto replay = generator();
+    for (auto &expected : recorded)
+    {
+        auto buf = replay->acquireBuffer();
+        REQUIRE(buf != nullptr);
+        REQUIRE(buf->encoding == PRISM_EVENTS_PACKED);
+        REQUIRE(buf->used == expected.get()->used);
+        for (unsigned i = 0; i < buf->used; ++i)
+            REQUIRE(same(buf->events[i], expected.get()->events[i]));
+
+        const PrismCxtEv &named = buf->events[buf->used / 2].cxt;
+        REQUIRE(std::string(replay->nameBase() + named.idx) == "main");
+
+        /* staging copies the whole name arena */
+        std::vector<char> staged(PRISM_NAMES_BUFFER_SIZE);
+        std::memcpy(staged.data(), replay->nameBase(), staged.size());
+        REQUIRE(std::string(staged.data() + named.idx) == "main");
+        replay->releaseBuffer(std::move(buf));
+    }
+    REQUIRE(replay->acquireBuffer() == nullptr);
+    replay.reset();
+
+    /* start partway through */
+    generator = startReplay({dir}, {"-s", "7", "-n", "2"}, 1, replayCapabilities(), IpcConfig{});
+    replay = generator();
+    auto buf = replay->acquireBuffer();
+    REQUIRE(buf != nullptr);
+    REQUIRE(buf->used == 107);
+    replay->releaseBuffer(std::move(buf));
+    buf = replay->acquireBuffer();
+    REQUIRE(buf != nullptr);
+    replay->releaseBuffer(std::move(buf));
+    REQUIRE(replay->acquireBuffer() == nullptr);
+    replay.reset();
+
+    unlink((std::string(dir) + "/prism-record-0").c_str());
+    rmdir(dir);
+}
+
+
+TEST_CASE("packed recordings replay unchanged", "[record]")
+{
+    roundTrip("none");
+}
+
+
+TEST_CASE("compact recordings replay unchanged", "[record]")
+{
+    roundTrip("compact");
+}
@@ -18,10 +18,10 @@ auto Handler::onSyncEv(const prism::SyncEvent &ev) -> void
 auto Handler::onCompEv(const prism::CompEvent &ev) -> void
 {
     /* aggregate compute costs for the current entity */
-    if (ev.isIOP())
-        cxt.incrIOPCost();
-    else if (ev.isFLOP())
-        cxt.incrFLOPCost();
+    if (ev.iops() > 0)
+        cxt.incrIOPCost(ev.iops());
+    if (ev.flops() > 0)
+        cxt.incrFLOPCost(ev.flops());
 }
 
 
@@ -1,7 +1,7 @@
 #ifndef SC_SHADOWMEMORY_H
 #define SC_SHADOWMEMORY_H
 
-#include "ShadowMemory.hpp"
+#include "Utils/ShadowMemory.hpp"
 
 namespace SigilClassic
 {
@@ -21,14 +21,22 @@ class SCShadowMemory
     auto updateReader(Addr addr, ByteCount bytes, FID fid) -> void;
     auto isReaderFID(Addr addr, FID fid) -> bool;
     auto getWriterFID(Addr addr) -> FID;
+    auto lookupHitRate() const -> double { return sm.tlbHitRate(); }
 
     struct ShadowObject
     {
-        FID last_writer{SO_UNDEF}; // Last function to write to addr
-        FID last_reader{SO_UNDEF}; //Last function to read addr
+        /* all zero bits, as mapped, is SO_UNDEF;
+         * functions are offset by one */
+        auto lastWriter() const -> FID { return writer - 1; }
+        auto lastReader() const -> FID { return reader - 1; }
+        auto setLastWriter(FID fid) -> void { writer = fid + 1; }
+        auto setLastReader(FID fid) -> void { reader = fid + 1; }
+
+        FID writer; // Last function to write to addr
+        FID reader; // Last function to read addr
     };
 
-    ShadowMemory<ShadowObject, 45, 28> sm;
+    ShadowMemory<ShadowObject> sm;
 };
 
 inline auto SCShadowMemory::updateWriter(Addr addr, ByteCount bytes, FID fid) -> void
@@ -36,8 +44,8 @@ inline auto SCShadowMemory::updateWriter(Addr addr, ByteCount bytes, FID fid) ->
     for (ByteCount i = 0; i < bytes; ++i)
     {
         ShadowObject &so = sm[addr + i];
-        so.last_writer = fid;
-        so.last_reader = SO_UNDEF; // Reset readers on new write
+        so.setLastWriter(fid);
+        so.setLastReader(SO_UNDEF); // Reset readers on new write
     }
 }
 
@@ -47,7 +55,7 @@ inline auto SCShadowMemory::updateReader(Addr addr, ByteCount bytes, FID fid) ->
     for (ByteCount i = 0; i < bytes; ++i)
     {
         ShadowObject &so = sm[addr + i];
-        so.last_reader = fid;
+        so.setLastReader(fid);
     }
 }
 
@@ -55,13 +63,13 @@ inline auto SCShadowMemory::updateReader(Addr addr, ByteCount bytes, FID fid) ->
 inline auto SCShadowMemory::isReaderFID(Addr addr, FID fid) -> bool
 {
     ShadowObject &so = sm[addr];
-    return so.last_reader == fid;
+    return so.lastReader() == fid;
 }
 
 
 inline auto SCShadowMemory::getWriterFID(Addr addr) -> FID
 {
-    return sm[addr].last_writer;
+    return sm[addr].lastWriter();
 }
 }; //end namespace SigilClassic
 
@@ -24,6 +24,7 @@ SigilContext::SigilContext()
 SigilContext::~SigilContext()
 {
     /* TODO Print out stats */
+    PrismLog::info("Shadow memory lookup cache hit rate: " + std::to_string(sm.lookupHitRate()));
 }
 
 auto SigilContext::setThreadContext(TID tid) -> void
@@ -98,15 +99,15 @@ auto SigilContext::monitorRead(Addr addr, ByteCount bytes) -> void
 }
 
 
-auto SigilContext::incrIOPCost() -> void
+auto SigilContext::incrIOPCost(unsigned n) -> void
 {
-    cur_entity->iops++;
+    cur_entity->iops += n;
 }
 
 
-auto SigilContext::incrFLOPCost() -> void
+auto SigilContext::incrFLOPCost(unsigned n) -> void
 {
-    cur_entity->flops++;
+    cur_entity->flops += n;
 }
 
 
@@ -76,8 +76,8 @@ struct SigilContext
 
     auto monitorWrite(Addr addr, ByteCount bytes) -> void;
     auto monitorRead(Addr addr, ByteCount bytes) -> void;
-    auto incrIOPCost() -> void;
-    auto incrFLOPCost() -> void;
+    auto incrIOPCost(unsigned n = 1) -> void;
+    auto incrFLOPCost(unsigned n = 1) -> void;
 
 
     SCShadowMemory sm;
@@ -4,6 +4,7 @@
 #include "spdlog/sinks/stdout_sinks.h"
 #include <iostream>
 #include <atomic>
+#include <mutex>
 
 namespace
 {
@@ -18,6 +19,8 @@ std::atomic<unsigned long> global_sync_cnt{0};
 std::atomic<unsigned long> global_cf_cnt{0};
 std::atomic<unsigned long> global_instr_cnt{0};
 std::atomic<unsigned long> global_cxt_cnt{0};
+std::atomic<unsigned long> global_bb_cnt{0};
+std::atomic<unsigned long> global_bb_instr_cnt{0};
 std::atomic<unsigned long> global_spawn_cnt{0};
 std::atomic<unsigned long> global_join_cnt{0};
 std::atomic<unsigned long> global_lock_cnt{0};
@@ -26,6 +29,9 @@ std::atomic<unsigned long> global_barrier_cnt{0};
 std::atomic<unsigned long> global_wait_cnt{0};
 std::atomic<unsigned long> global_sig_cnt{0};
 std::atomic<unsigned long> global_broad_cnt{0};
+
+std::mutex samples_mtx;
+prism::SampleWindow global_samples;
 };
 
 namespace SimpleCount
@@ -74,11 +80,9 @@ auto Handler::onSyncEv(const prism::SyncEvent &ev) -> void
 
 auto Handler::onCompEv(const prism::CompEvent &ev) -> void
 {
-    ++comp_cnt;
-    if (ev.isIOP())
-        ++iop_cnt;
-    else if (ev.isFLOP())
-        ++flop_cnt;
+    comp_cnt += ev.ops();
+    iop_cnt += ev.iops();
+    flop_cnt += ev.flops();
 }
 
 
@@ -102,7 +106,18 @@ auto Handler::onCxtEv(const prism::CxtEvent &ev) -> void
 {
     ++cxt_cnt;
     if (ev.type() == PRISM_CXT_INSTR)
+    {
         ++instr_cnt;
+    }
+    else if (ev.type() == PRISM_CXT_BB)
+    {
+        ++bb_cnt;
+        bb_instr_cnt += ev.bbInstrs();
+    }
+    else
+    {
+        samples.onCxt(ev);
+    }
 }
 
 
@@ -119,6 +134,8 @@ Handler::~Handler()
     global_cf_cnt      += cf_cnt;
     global_cxt_cnt     += cxt_cnt;
     global_instr_cnt   += instr_cnt;
+    global_bb_cnt      += bb_cnt;
+    global_bb_instr_cnt += bb_instr_cnt;
     global_spawn_cnt   += spawn_cnt;
     global_join_cnt    += join_cnt;
     global_lock_cnt    += lock_cnt;
@@ -127,6 +144,9 @@ Handler::~Handler()
     global_wait_cnt    += wait_cnt;
     global_sig_cnt     += sig_cnt;
     global_broad_cnt   += broad_cnt;
+
+    std::lock_guard<std::mutex> lock(samples_mtx);
+    global_samples.merge(samples);
 }
 
 
@@ -138,25 +158,43 @@ auto cleanup() -> void
 
     logger->set_pattern("[SimpleCount] %v");
 
-    logger->info("Total Compute   Events: {}", std::to_string(global_comp_cnt));
-    logger->info("Total IOP       Events: {}", std::to_string(global_iop_cnt));
-    logger->info("Total FLOP      Events: {}", std::to_string(global_flop_cnt));
-    logger->info("Total Memory    Events: {}", std::to_string(global_mem_cnt));
-    logger->info("Total ReadMem   Events: {}", std::to_string(global_read_cnt));
-    logger->info("Total WriteMem  Events: {}", std::to_string(global_write_cnt));
-    logger->info("Total Swap      Events: {}", std::to_string(global_swap_cnt));
-    logger->info("Total Sync      Events: {}", std::to_string(global_sync_cnt));
-    logger->info("Total Spawn     Events: {}", std::to_string(global_spawn_cnt));
-    logger->info("Total Join      Events: {}", std::to_string(global_join_cnt));
-    logger->info("Total Lock      Events: {}", std::to_string(global_lock_cnt));
-    logger->info("Total Unlock    Events: {}", std::to_string(global_unlock_cnt));
-    logger->info("Total Barrier   Events: {}", std::to_string(global_barrier_cnt));
-    logger->info("Total Wait      Events: {}", std::to_string(global_wait_cnt));
-    logger->info("Total Signal    Events: {}", std::to_string(global_sig_cnt));
-    logger->info("Total Broadcast Events: {}", std::to_string(global_broad_cnt));
-    logger->info("Total CntlFlow  Events: {}", std::to_string(global_cf_cnt));
-    logger->info("Total Instr     Events: {}", std::to_string(global_instr_cnt));
-    logger->info("Total Context   Events: {}", std::to_string(global_cxt_cnt));
+    /* totals of a sampled stream are also extrapolated to the whole run */
+    auto total = [&](const char *name, unsigned long cnt)
+    {
+        if (global_samples.sampled())
+            logger->info("Total {}Events: {} (extrapolated: {})",
+                         name, cnt, global_samples.extrapolate(cnt));
+        else
+            logger->info("Total {}Events: {}", name, cnt);
+    };
+
+    if (global_samples.sampled())
+        logger->info("Sampled {} of {} instructions in {} samples",
+                     global_samples.sampledInstructions(),
+                     global_samples.elapsedInstructions(),
+                     global_samples.samples());
+
+    total("Compute   ", global_comp_cnt);
+    total("IOP       ", global_iop_cnt);
+    total("FLOP      ", global_flop_cnt);
+    total("Memory    ", global_mem_cnt);
+    total("ReadMem   ", global_read_cnt);
+    total("WriteMem  ", global_write_cnt);
+    total("Swap      ", global_swap_cnt);
+    total("Sync      ", global_sync_cnt);
+    total("Spawn     ", global_spawn_cnt);
+    total("Join      ", global_join_cnt);
+    total("Lock      ", global_lock_cnt);
+    total("Unlock    ", global_unlock_cnt);
+    total("Barrier   ", global_barrier_cnt);
+    total("Wait      ", global_wait_cnt);
+    total("Signal    ", global_sig_cnt);
+    total("Broadcast ", global_broad_cnt);
+    total("CntlFlow  ", global_cf_cnt);
+    total("Instr     ", global_instr_cnt);
+    total("BasicBlk  ", global_bb_cnt);
+    total("BB Instr  ", global_bb_instr_cnt);
+    total("Context   ", global_cxt_cnt);
 }
 
 
@@ -2,6 +2,7 @@
 #define SIMPLECOUNT_H
 
 #include "Core/Backends.hpp"
+#include "Core/Sampling.hpp"
 
 namespace SimpleCount
 {
@@ -10,10 +11,13 @@ auto cleanup() -> void;
 auto requirements() -> prism::capabilities;
 /* Prism hooks */
 
-class Handler : public BackendIface
+class Handler : public BatchedBackendIface<Handler>
 {
     /* interface to Prism */
 
+    friend class BatchedBackendIface<Handler>;
+    /* batched dispatch calls the private hooks directly */
+
     virtual auto onSyncEv(const prism::SyncEvent &ev) -> void override;
     virtual auto onCompEv(const prism::CompEvent &ev) -> void override;
     virtual auto onMemEv(const prism::MemEvent &ev) -> void override;
@@ -43,6 +47,11 @@ class Handler : public BackendIface
 
     unsigned long instr_cnt{0};
     unsigned long cxt_cnt{0};
+    unsigned long bb_cnt{0};
+    unsigned long bb_instr_cnt{0};
+    /* instructions counted from basic block events */
+
+    prism::SampleWindow samples;
 
   public:
     virtual ~Handler() override;
@@ -31,11 +31,14 @@ TCxtGenerator genTCxt;
 
 StatCounter maxOps;
 StatCounter totalOps{0};
+StatCounter shadowReleaseOps{0};
+StatCounter nextShadowRelease{0};
 std::mutex gMtx;
 ThreadStatMap allThreadsStats;
 SpawnList threadSpawns;
 ThreadList newThreadsInOrder;
 BarrierList barrierParticipants;
+prism::SampleWindow allSamples;
 }; //end namespace
 
 
@@ -62,16 +65,18 @@ auto EventHandlers::onSyncEv(const prism::SyncEvent &ev) -> void
 /** Compute Event Handling **/
 auto EventHandlers::onCompEv(const prism::CompEvent &ev) -> void
 {
-    if (ev.isIOP())
-        cachedTCxt->onIop();
-    else if (ev.isFLOP())
-        cachedTCxt->onFlop();
-    totalOps++;
+    /* a batch carries the counts of a run of ops */
+    if (ev.iops() > 0)
+        cachedTCxt->onIop(ev.iops());
+    if (ev.flops() > 0)
+        cachedTCxt->onFlop(ev.flops());
+    totalOps += ev.ops();
     if (totalOps >= maxOps)
     {
         std::lock_guard<std::mutex> lock(gMtx);
         for (auto& p : tcxts)
             allThreadsStats.emplace(p.first, p.second->getStats());
+        allSamples.merge(samples);
         onExit();
         delete cachedTCxt;
         exit(0);
@@ -88,11 +93,17 @@ auto EventHandlers::onMemEv(const prism::MemEvent &ev) -> void
     else if (ev.isStore())
         cachedTCxt->onWrite(ev.addr(), ev.bytes());
     totalOps++;
+    if (shadowReleaseOps > 0 && totalOps >= nextShadowRelease)
+    {
+        ThreadContext::releaseColdShadow();
+        nextShadowRelease = totalOps + shadowReleaseOps;
+    }
     if (totalOps >= maxOps)
     {
         std::lock_guard<std::mutex> lock(gMtx);
         for (auto& p : tcxts)
             allThreadsStats.emplace(p.first, p.second->getStats());
+        allSamples.merge(samples);
         onExit();
         delete cachedTCxt;
         exit(0);
@@ -107,6 +118,10 @@ auto EventHandlers::onCxtEv(const prism::CxtEvent &ev) -> void
 {
     if (ev.type() == CxtTypeEnum::PRISM_CXT_INSTR)
         cachedTCxt->onInstr();
+    else if (ev.type() == CxtTypeEnum::PRISM_CXT_BB)
+        cachedTCxt->onInstrs(ev.bbInstrs());
+    else
+        samples.onCxt(ev);
 }
 
 
@@ -117,6 +132,7 @@ EventHandlers::~EventHandlers()
     std::lock_guard<std::mutex> lock(gMtx);
     for (auto& p : tcxts)
         allThreadsStats.emplace(p.first, p.second->getStats());
+    allSamples.merge(samples);
 }
 
 
@@ -125,7 +141,8 @@ auto onExit() -> void
     //std::lock_guard<std::mutex> lock(gMtx);
     flushPthread(outputPath + "/sigil.pthread.out", newThreadsInOrder,
                  threadSpawns, barrierParticipants);
-    flushStats(outputPath + "/sigil.stats.out", allThreadsStats);
+    flushStats(outputPath + "/sigil.stats.out", allThreadsStats, allSamples,
+               ThreadContext::shadowStats());
 }
 
 
@@ -376,6 +393,29 @@ auto parseMaxOps(std::string maxops) -> unsigned long long
     }
 }
 
+auto parseShadowRelease(std::string ops) -> unsigned long long
+{
+    if (ops.empty() == true)
+        return 0; // never
+
+    try
+    {
+        return std::stoull(ops);
+    }
+    catch (std::invalid_argument &e)
+    {
+        fatal("SynchroTraceGen shadow release: invalid argument");
+    }
+    catch (std::out_of_range &e)
+    {
+        fatal("SynchroTraceGen shadow release: out_of_range");
+    }
+    catch (std::exception &e)
+    {
+        fatal(std::string("SynchroTraceGen shadow release: ").append(e.what()));
+    }
+}
+
 auto parseOutputPath(std::string outputPath) -> std::string
 {
     if (outputPath.empty() == true)
@@ -393,12 +433,15 @@ auto onParse(Args args) -> void
     options.insert('c'); // -c COMPRESSION_VALUE
     options.insert('l'); // -l {text,capnp}
     options.insert('n'); // -n MAX_OPS
+    options.insert('s'); // -s SHADOW_RELEASE_OPS
     auto matches = parseAll(args, options);
 
     outputPath = parseOutputPath(matches['o']);
     loggerType = parseLogger(matches['l']);
     primsPerStCompEv = parseCompression(matches['c']);
     maxOps = parseMaxOps(matches['n']);
+    shadowReleaseOps = parseShadowRelease(matches['s']);
+    nextShadowRelease = shadowReleaseOps;
 
     std::cout << "Tracing for Max Ops : " << maxOps << std::endl;
 
@@ -3,6 +3,7 @@
 
 #include "Core/Backends.hpp"
 #include "ThreadContext.hpp"
+#include "Core/Sampling.hpp"
 
 namespace STGen
 {
@@ -12,7 +13,7 @@ auto onExit() -> void;
 auto requirements() -> prism::capabilities;
 /* Prism hooks */
 
-class EventHandlers : public BackendIface
+class EventHandlers : public BatchedBackendIface<EventHandlers>
 {
   public:
     EventHandlers() {}
@@ -36,6 +37,7 @@ class EventHandlers : public BackendIface
     std::unordered_map<TID, std::unique_ptr<ThreadContext>> tcxts;
     TID currentTID{SO_UNDEF};
     ThreadContext *cachedTCxt{nullptr};
+    prism::SampleWindow samples;
 };
 
 }; //end namespace STGen
@@ -29,16 +29,16 @@ auto STCompEventCompressed::incReads() -> void
     ++reads;
 }
 
-auto STCompEventCompressed::incIOP() -> void
+auto STCompEventCompressed::incIOP(StatCounter n) -> void
 {
     isActive = true;
-    ++iops;
+    iops += n;
 }
 
-auto STCompEventCompressed::incFLOP() -> void
+auto STCompEventCompressed::incFLOP(StatCounter n) -> void
 {
     isActive = true;
-    ++flops;
+    flops += n;
 }
 
 auto STCompEventCompressed::reset() -> void
@@ -53,16 +53,16 @@ auto STCompEventCompressed::reset() -> void
 }
 
 
-auto STCompEventUncompressed::incIOP() -> void
+auto STCompEventUncompressed::incIOP(StatCounter n) -> void
 {
     isActive = true;
-    ++iops;
+    iops += n;
 }
 
-auto STCompEventUncompressed::incFLOP() -> void
+auto STCompEventUncompressed::incFLOP(StatCounter n) -> void
 {
     isActive = true;
-    ++flops;
+    flops += n;
 }
 
 auto STCompEventUncompressed::reset() -> void
@@ -77,13 +77,14 @@ auto STCompEventUncompressed::reset() -> void
 //-----------------------------------------------------------------------------
 /** Communication Event **/
 auto STCommEventCompressed::addEdge(const TID writer, const EID writer_event,
-                                    const Addr addr) -> void
+                                    const Addr addr, const Addr size) -> void
 {
     isActive = true;
+    auto range = std::make_pair(addr, addr + size - 1);
 
     if (comms.empty())
     {
-        comms.push_back(std::make_tuple(writer, writer_event, AddrSet(std::make_pair(addr, addr))));
+        comms.push_back(std::make_tuple(writer, writer_event, AddrSet(range)));
     }
     else
     {
@@ -91,12 +92,12 @@ auto STCommEventCompressed::addEdge(const TID writer, const EID writer_event,
         {
             if (std::get<0>(edge) == writer && std::get<1>(edge) == writer_event)
             {
-                std::get<2>(edge).insert(std::make_pair(addr, addr));
+                std::get<2>(edge).insert(range);
                 return;
             }
         }
 
-        comms.push_back(std::make_tuple(writer, writer_event, AddrSet(std::make_pair(addr, addr))));
+        comms.push_back(std::make_tuple(writer, writer_event, AddrSet(range)));
     }
 }
 
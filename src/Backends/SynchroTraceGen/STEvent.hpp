@@ -41,8 +41,8 @@ struct STCompEventCompressed
     auto updateReads(Addr begin, Addr size) -> void;
     auto incWrites() -> void;
     auto incReads() -> void;
-    auto incIOP() -> void;
-    auto incFLOP() -> void;
+    auto incIOP(StatCounter n = 1) -> void;
+    auto incFLOP(StatCounter n = 1) -> void;
     auto reset() -> void;
 
     StatCounter iops{0};
@@ -63,8 +63,8 @@ struct STCompEventCompressed
 
 struct STCompEventUncompressed
 {
-    auto incIOP() -> void;
-    auto incFLOP() -> void;
+    auto incIOP(StatCounter n = 1) -> void;
+    auto incFLOP(StatCounter n = 1) -> void;
     auto reset() -> void;
 
     StatCounter iops{0};
@@ -101,8 +101,9 @@ struct STCommEventCompressed
      * addresses 0x0000-0x0008 were all read, instead of non-consecutively read.
      *
      * Use STEvent::flush() between different read primitives.
+     * A run of 'size' bytes is the same as one call per byte.
      */
-    auto addEdge(TID writer, EID writer_event, Addr addr) -> void;
+    auto addEdge(TID writer, EID writer_event, Addr addr, Addr size = 1) -> void;
     auto reset() -> void;
 
     /**
@@ -1,11 +1,14 @@
 #ifndef STGEN_SHADOWMEMORY_H
 #define STGEN_SHADOWMEMORY_H
 
-#include "ShadowMemory.hpp"
+#include "Utils/ShadowMemory.hpp"
 #include "STTypes.hpp"
 
 #include <cstdint>
 #include <bitset>
+#include <utility>
+#include <mutex>
+#include <unordered_map>
 
 
 namespace STGen
@@ -15,11 +18,14 @@ constexpr TID SO_UNDEF = -1;
 constexpr TID MAX_THREADS = 128;
 static_assert((MAX_THREADS > 0) && !(MAX_THREADS & (MAX_THREADS-1)),
               "MAX_THREADS must be a power of 2");
+static_assert(MAX_THREADS <= 128, "thread IDs are packed into 8 bits of shadow state");
 
 class STShadowMemory
 {
     /* In SynchroTraceGen, 'shadow state' takes the form of
-     * the most recent thread to {read from, write to} an address.  */
+     * the most recent thread to {read from, write to} an address.
+     * One shadow memory is shared by every thread context, so each
+     * operation holds a lock; 'sm' itself is not synchronized.  */
   public:
     auto updateWriter(Addr addr, ByteCount bytes, TID tid, EID eid) -> void;
     auto updateReader(Addr addr, ByteCount bytes, TID tid) -> void;
@@ -27,31 +33,185 @@ class STShadowMemory
     auto getWriterEID(Addr addr) -> EID;
     auto isReaderTID(Addr addr, TID tid) -> bool;
 
+    auto releaseCold() -> Addr;
+    /* Forget the state of shadow maps not accessed since the last call,
+     * and return their memory; see ShadowMemory::releaseCold */
+    auto outOfRange() const -> Addr
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sm.outOfRange();
+    }
+    /* Accesses past the shadowed address range have no shadow state;
+     * they read as never written, and are counted instead */
+    auto lookupHitRate() const -> double
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sm.tlbHitRate();
+    }
+    /* fraction of shadow map lookups served by the translation cache */
+
+    /* Calls f(addr, bytes, writer, writerEID, isReader) for each run of
+     * consecutive bytes in [addr, addr+bytes) with the same last writer and
+     * the same reader state for 'tid', in address order, until f returns false.
+     * Each byte of a run would give the same per-byte answers, and a load
+     * of identical bytes, the common case, is a single run.
+     * f is called with the lock held, and must not use the shadow memory */
+    template <typename F>
+    auto forEachWriterRun(Addr addr, ByteCount bytes, TID tid, F &&f) -> void;
+
+    /* A load: forEachWriterRun, and then 'tid' reads every byte visited,
+     * up to the first byte of the run f stopped at, under a single lock */
+    template <typename F>
+    auto readRuns(Addr addr, ByteCount bytes, TID tid, F &&f) -> void;
+
+    static constexpr TID INLINE_READERS = 23;
+    static constexpr uint32_t OVERFLOW_READERS = 1U << INLINE_READERS;
+    static constexpr uint32_t MAX_READER_SETS = OVERFLOW_READERS;
+
     struct ShadowObject
     {
-        TID last_writer{SO_UNDEF};
-        EID last_writer_event{0};
-        /* Last thread/event to read/write to addr */
-    
-        std::bitset<MAX_THREADS> last_readers;
-        /* A bitfield -- each bit represents a thread
-         * each address can have multiple readers */
+        /* all zero bits, as mapped, is no writer and no readers */
+        auto lastWriter() const -> TID { return static_cast<TID>(writer) - 1; }
+        auto setLastWriter(TID tid) -> void { writer = tid + 1; }
+
+        EID last_writer_event;
+        uint32_t writer : 8;
+        /* Last thread/event to write to addr; the thread is offset by one
+         * so that SO_UNDEF is zero */
+
+        uint32_t last_readers : 24;
+        /* Threads that read addr since the last write.
+         * Readers below INLINE_READERS are a bitfield -- each bit represents
+         * a thread. Any other set is interned in ReaderSets; the bitfield
+         * is then the set's id, tagged with OVERFLOW_READERS */
+    };
+    static_assert(sizeof(ShadowObject) == 8, "shadow state is 8 bytes per byte");
+
+    ShadowMemory<ShadowObject> sm;
+    /* covers the full user address space, including DynamoRIO's high addresses */
+
+  private:
+    class ReaderSets
+    {
+        /* Reader sets that do not fit inline, shared by every byte with
+         * the same readers. Few distinct sets are live at once, even when
+         * many bytes are read by many threads */
+      public:
+        using Set = std::bitset<MAX_THREADS>;
+
+        auto get(uint32_t id) const -> const Set& { return sets[id].first; }
+        auto acquire(const Set &set) -> uint32_t;
+        auto acquire(uint32_t id) -> uint32_t { ++sets[id].second; return id; }
+        auto release(uint32_t id) -> void;
+
+      private:
+        std::vector<std::pair<Set, uint64_t>> sets; // set, reference count
+        std::unordered_map<Set, uint32_t> ids;
+        std::vector<uint32_t> freeIds;
     };
 
-    ShadowMemory<ShadowObject, 38, 20> sm;
-    /* ADDR_BITS = 48, PM_BITS = 28 is more appropriate for DynamoRIO */
+    template <typename F>
+    auto visitRuns(Addr addr, ByteCount bytes, TID tid, F &&f) -> Addr;
+    auto addReaders(Addr addr, ByteCount bytes, TID tid) -> void;
+    /* unlocked; visitRuns returns the end of the bytes visited */
+
+    auto isReader(const ShadowObject &so, TID tid) const -> bool;
+    auto addReader(ShadowObject &so, TID tid) -> void;
+    auto clearReaders(ShadowObject &so) -> void;
+
+    ReaderSets readerSets;
+    mutable std::mutex mtx;
 };
 
 
+inline auto STShadowMemory::ReaderSets::acquire(const Set &set) -> uint32_t
+{
+    auto it = ids.find(set);
+    if (it != ids.end())
+        return acquire(it->second);
+
+    uint32_t id;
+    if (freeIds.empty() == false)
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+        sets[id] = std::make_pair(set, 1);
+    }
+    else
+    {
+        if (sets.size() == MAX_READER_SETS)
+            fatal("shadow memory out of reader sets");
+        id = sets.size();
+        sets.emplace_back(set, 1);
+    }
+    ids.emplace(set, id);
+    return id;
+}
+
+
+inline auto STShadowMemory::ReaderSets::release(uint32_t id) -> void
+{
+    if (--sets[id].second == 0)
+    {
+        ids.erase(sets[id].first);
+        freeIds.push_back(id);
+    }
+}
+
+
+inline auto STShadowMemory::isReader(const ShadowObject &so, TID tid) const -> bool
+{
+    if ((so.last_readers & OVERFLOW_READERS) == 0)
+        return tid < INLINE_READERS && (so.last_readers >> tid & 1);
+    return readerSets.get(so.last_readers & ~OVERFLOW_READERS).test(tid);
+}
+
+
+inline auto STShadowMemory::addReader(ShadowObject &so, TID tid) -> void
+{
+    bool inlined = (so.last_readers & OVERFLOW_READERS) == 0;
+    if (inlined == true && tid < INLINE_READERS)
+    {
+        so.last_readers |= 1U << tid;
+        return;
+    }
+
+    if (isReader(so, tid) == true)
+        return;
+
+    ReaderSets::Set set = inlined ? ReaderSets::Set(so.last_readers)
+                                  : readerSets.get(so.last_readers & ~OVERFLOW_READERS);
+    set.set(tid);
+    uint32_t id = readerSets.acquire(set);
+    clearReaders(so);
+    so.last_readers = OVERFLOW_READERS | id;
+}
+
+
+inline auto STShadowMemory::clearReaders(ShadowObject &so) -> void
+{
+    if ((so.last_readers & OVERFLOW_READERS) != 0)
+        readerSets.release(so.last_readers & ~OVERFLOW_READERS);
+    so.last_readers = 0;
+}
+
+
 inline auto STShadowMemory::updateWriter(Addr addr, ByteCount bytes, TID tid, EID eid) -> void
 {
     assert(tid < MAX_THREADS);
-    for (ByteCount i = 0; i < bytes; ++i)
+    std::lock_guard<std::mutex> lock(mtx);
+    while (bytes > 0)
     {
-        ShadowObject &so = sm[addr + i];
-        so.last_writer = tid;
-        so.last_writer_event = eid;
-        so.last_readers.reset();
+        auto span = sm.span(addr, bytes);
+        for (Addr i = 0; span.first != nullptr && i < span.second; ++i)
+        {
+            ShadowObject &so = span.first[i];
+            so.setLastWriter(tid);
+            so.last_writer_event = eid;
+            clearReaders(so);
+        }
+        addr += span.second;
+        bytes -= span.second;
     }
 }
 
@@ -59,30 +219,131 @@ inline auto STShadowMemory::updateWriter(Addr addr, ByteCount bytes, TID tid, EI
 inline auto STShadowMemory::updateReader(Addr addr, ByteCount bytes, TID tid) -> void
 {
     assert(tid < MAX_THREADS);
-    for (ByteCount i = 0; i < bytes; ++i)
+    std::lock_guard<std::mutex> lock(mtx);
+    addReaders(addr, bytes, tid);
+}
+
+
+inline auto STShadowMemory::addReaders(Addr addr, ByteCount bytes, TID tid) -> void
+{
+    /* neighbouring bytes usually share their readers,
+     * so reuse the last overflowed set instead of interning it again */
+    bool memo = false;
+    uint32_t lastBefore = 0;
+    uint32_t lastAfter = 0;
+
+    while (bytes > 0)
     {
-        ShadowObject &so = sm[addr + i];
-        so.last_readers.set(tid);
+        auto span = sm.span(addr, bytes);
+        for (Addr i = 0; span.first != nullptr && i < span.second; ++i)
+        {
+            ShadowObject &so = span.first[i];
+            if (memo == true && so.last_readers == lastBefore)
+            {
+                readerSets.acquire(lastAfter & ~OVERFLOW_READERS);
+                clearReaders(so);
+                so.last_readers = lastAfter;
+                continue;
+            }
+
+            uint32_t before = so.last_readers;
+            addReader(so, tid);
+            if ((so.last_readers & OVERFLOW_READERS) != 0 && so.last_readers != before)
+            {
+                memo = true;
+                lastBefore = before;
+                lastAfter = so.last_readers;
+            }
+        }
+        addr += span.second;
+        bytes -= span.second;
     }
 }
 
 
+template <typename F>
+auto STShadowMemory::forEachWriterRun(Addr addr, ByteCount bytes, TID tid, F &&f) -> void
+{
+    assert(tid < MAX_THREADS);
+    std::lock_guard<std::mutex> lock(mtx);
+    visitRuns(addr, bytes, tid, std::forward<F>(f));
+}
+
+
+template <typename F>
+auto STShadowMemory::readRuns(Addr addr, ByteCount bytes, TID tid, F &&f) -> void
+{
+    assert(tid < MAX_THREADS);
+    std::lock_guard<std::mutex> lock(mtx);
+    Addr end = visitRuns(addr, bytes, tid, std::forward<F>(f));
+    addReaders(addr, end - addr, tid);
+}
+
+
+template <typename F>
+auto STShadowMemory::visitRuns(Addr addr, ByteCount bytes, TID tid, F &&f) -> Addr
+{
+    while (bytes > 0)
+    {
+        auto span = sm.span(addr, bytes);
+        const ShadowObject *so = span.first;
+        if (so == nullptr && f(addr, span.second, SO_UNDEF, 0, false) == false)
+            return addr + 1;
+        for (Addr i = 0; so != nullptr && i < span.second;)
+        {
+            uint32_t writer = so[i].writer;
+            EID eid = so[i].last_writer_event;
+            uint32_t readers = so[i].last_readers;
+            bool reader = isReader(so[i], tid);
+
+            Addr j = i + 1;
+            while (j < span.second &&
+                   so[j].writer == writer &&
+                   so[j].last_writer_event == eid &&
+                   (so[j].last_readers == readers || isReader(so[j], tid) == reader))
+                ++j;
+
+            if (f(addr + i, j - i, so[i].lastWriter(), eid, reader) == false)
+                return addr + i + 1;
+            i = j;
+        }
+        addr += span.second;
+        bytes -= span.second;
+    }
+    return addr;
+}
+
+
 inline auto STShadowMemory::isReaderTID(Addr addr, TID tid) -> bool
 {
     assert(tid < MAX_THREADS);
-    ShadowObject &so = sm[addr];
-    return so.last_readers.test(tid);
+    std::lock_guard<std::mutex> lock(mtx);
+    return isReader(sm[addr], tid);
 }
 
 
 inline auto STShadowMemory::getWriterTID(Addr addr) -> TID
 {
-    return sm[addr].last_writer;
+    std::lock_guard<std::mutex> lock(mtx);
+    return sm[addr].lastWriter();
+}
+
+
+inline auto STShadowMemory::releaseCold() -> Addr
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return sm.releaseCold([this](ShadowObject *so, Addr count)
+    {
+        for (Addr i = 0; i < count; ++i)
+            if (so[i].last_readers != 0)
+                clearReaders(so[i]);
+    });
 }
 
 
 inline auto STShadowMemory::getWriterEID(Addr addr) -> EID
 {
+    std::lock_guard<std::mutex> lock(mtx);
     return sm[addr].last_writer_event;
 }
 
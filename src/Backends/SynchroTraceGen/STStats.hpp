@@ -1,7 +1,7 @@
 #ifndef STGEN_STATS_H
 #define STGEN_STATS_H
 
-#include "ShadowMemory.hpp" //Addr
+#include "Utils/ShadowMemory.hpp" //Addr
 #include <tuple>
 #include <list>
 
@@ -59,13 +59,21 @@ struct LockStats
     StatCounter communication{0};
 };
 
+struct ShadowStats
+{
+    /* Shadow memory statistics, for the whole run */
+
+    StatCounter outOfRange{0};
+    double lookupHitRate{0};
+};
+
 using AllBarriersStats = std::list<std::pair<Addr, BarrierStats>>;
 class PerBarrierStats
 {
   public:
-    auto incIOPs() -> void { ++current.iops; }
-    auto incFLOPs() -> void { ++current.flops; }
-    auto incInstrs() -> void { ++current.instrs; }
+    auto incIOPs(StatCounter n = 1) -> void { current.iops += n; }
+    auto incFLOPs(StatCounter n = 1) -> void { current.flops += n; }
+    auto incInstrs(StatCounter n = 1) -> void { current.instrs += n; }
     auto incMemAccesses() -> void { ++current.memAccesses; }
     auto incComm() -> void { ++current.communication; }
     auto incLocks() -> void { ++current.locks; }
@@ -86,9 +94,9 @@ class PerLockStats
 {
     /* XXX Assumes common case of only one lock held at a time */
   public:
-    auto incIOPs() -> void { if (active == true) ++current.iops; }
-    auto incFLOPs() -> void { if (active == true) ++current.flops; }
-    auto incInstrs() -> void { if (active == true) ++current.instrs; }
+    auto incIOPs(StatCounter n = 1) -> void { if (active == true) current.iops += n; }
+    auto incFLOPs(StatCounter n = 1) -> void { if (active == true) current.flops += n; }
+    auto incInstrs(StatCounter n = 1) -> void { if (active == true) current.instrs += n; }
     auto incMemAccesses() -> void { if (active == true) ++current.memAccesses; }
     auto incComm() -> void { if (active == true) ++current.communication; }
     auto lock() -> void { active = true; }
@@ -109,25 +117,25 @@ class PerLockStats
 class PerThreadStats
 {
   public:
-    auto incIOPs() -> void
+    auto incIOPs(StatCounter n = 1) -> void
     {
-        ++std::get<IOP>(stats);
-        barrierStats.incIOPs();
-        lockStats.incIOPs();
+        std::get<IOP>(stats) += n;
+        barrierStats.incIOPs(n);
+        lockStats.incIOPs(n);
     }
 
-    auto incFLOPs() -> void
+    auto incFLOPs(StatCounter n = 1) -> void
     {
-        ++std::get<FLOP>(stats);
-        barrierStats.incFLOPs();
-        lockStats.incFLOPs();
+        std::get<FLOP>(stats) += n;
+        barrierStats.incFLOPs(n);
+        lockStats.incFLOPs(n);
     }
 
-    auto incInstrs() -> void
+    auto incInstrs(StatCounter n = 1) -> void
     {
-        ++std::get<INSTR>(stats);
-        barrierStats.incInstrs();
-        lockStats.incInstrs();
+        std::get<INSTR>(stats) += n;
+        barrierStats.incInstrs(n);
+        lockStats.incInstrs(n);
     }
 
     auto getTotalInstrs() -> StatCounter
@@ -1,7 +1,7 @@
 #ifndef STGEN_TYPES_H
 #define STGEN_TYPES_H
 
-#include "ShadowMemory.hpp" //Addr
+#include "Utils/ShadowMemory.hpp" //Addr
 #include "STStats.hpp"
 #include <set>
 #include <map>
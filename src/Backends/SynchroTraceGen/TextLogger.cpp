@@ -1,5 +1,6 @@
 #include "TextLogger.hpp"
 #include "spdlog/fmt/fmt.h"
+#include <sys/resource.h>
 
 namespace STGen
 {
@@ -225,7 +226,8 @@ auto flushPthread(std::string filePath,
 }
 
 
-auto flushStats(std::string filePath, ThreadStatMap allThreadsStats) -> void
+auto flushStats(std::string filePath, ThreadStatMap allThreadsStats,
+                const prism::SampleWindow &samples, const ShadowStats &shadowStats) -> void
 {
     auto loggerPair = prism::getFileLogger(filePath);
     auto logger = std::move(loggerPair.first);
@@ -294,6 +296,26 @@ auto flushStats(std::string filePath, ThreadStatMap allThreadsStats) -> void
     }
 
     logger->info("Total instructions for all threads: {}", totalInstrs);
+    if (samples.sampled())
+    {
+        /* only part of the run was traced */
+        logger->info("Sampled {} of {} instructions in {} samples",
+                     samples.sampledInstructions(),
+                     samples.elapsedInstructions(),
+                     samples.samples());
+        logger->info("Extrapolated instructions for all threads: {}",
+                     samples.extrapolate(totalInstrs));
+    }
+
+    if (shadowStats.outOfRange > 0)
+        logger->info("Memory accesses past the shadowed address range: {}",
+                     shadowStats.outOfRange);
+    logger->info("Shadow memory lookup cache hit rate: {:.4f}", shadowStats.lookupHitRate);
+
+    /* shadow memory dominates, so this tracks its footprint */
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        logger->info("Peak resident memory (KB): {}", usage.ru_maxrss);
     logger->flush();
     prism::blockingFlushAndDeleteLogger(logger);
 }
@@ -5,6 +5,7 @@
 #include "Utils/FileLogger.hpp"
 #include "STLogger.hpp"
 #include "BarrierMerge.hpp"
+#include "Core/Sampling.hpp"
 #include "spdlog/spdlog.h"
 
 using PrismLog::info;
@@ -69,7 +70,8 @@ auto flushPthread(std::string filePath,
                   SpawnList threadSpawns,
                   BarrierList barrierParticipants) -> void;
 
-auto flushStats(std::string filePath, ThreadStatMap allThreadsStats) -> void;
+auto flushStats(std::string filePath, ThreadStatMap allThreadsStats,
+                const prism::SampleWindow &samples, const ShadowStats &shadowStats) -> void;
 
 }; //end namespace STGen
 
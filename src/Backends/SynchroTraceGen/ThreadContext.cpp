@@ -35,25 +35,40 @@ ThreadContextCompressed::~ThreadContextCompressed()
 }
 
 
+auto ThreadContext::releaseColdShadow() -> void
+{
+    shadow.releaseCold();
+}
+
+
+auto ThreadContext::shadowStats() -> ShadowStats
+{
+    ShadowStats stats;
+    stats.outOfRange = shadow.outOfRange();
+    stats.lookupHitRate = shadow.lookupHitRate();
+    return stats;
+}
+
+
 auto ThreadContextCompressed::getStats() const -> PerThreadStats
 {
     return stats;
 }
 
 
-auto ThreadContextCompressed::onIop() -> void
+auto ThreadContextCompressed::onIop(unsigned n) -> void
 {
     commFlushIfActive();
-    stComp.incIOP();
-    stats.incIOPs();
+    stComp.incIOP(n);
+    stats.incIOPs(n);
 }
 
 
-auto ThreadContextCompressed::onFlop() -> void
+auto ThreadContextCompressed::onFlop(unsigned n) -> void
 {
     commFlushIfActive();
-    stComp.incFLOP();
-    stats.incFLOPs();
+    stComp.incFLOP(n);
+    stats.incFLOPs(n);
 }
 
 
@@ -62,37 +77,23 @@ auto ThreadContextCompressed::onRead(Addr start, Addr bytes) -> void
     bool isCommEdge = false;
 
     /* Each byte of the read may have been touched by a different thread,
-     * so check the reader/writer pair for each byte */
-    for (Addr i = 0; i < bytes; ++i)
+     * so check the reader/writer pair for each run of like bytes */
+    shadow.readRuns(start, bytes, tid,
+                    [&](Addr addr, Addr size, TID writer, EID eid, bool isReader)
     {
-        Addr addr = start + i;
-        try
+        if ((isReader == false) && (writer != tid) && (writer != SO_UNDEF))
         {
-            TID writer = shadow.getWriterTID(addr);
-            bool isReader= shadow.isReaderTID(addr, tid);
-
-            if (isReader == false)
-                shadow.updateReader(addr, 1, tid);
-
-            if ((isReader == false) && (writer != tid) && (writer != SO_UNDEF))
-            {
-                isCommEdge = true;
-                stComm.addEdge(writer, shadow.getWriterEID(addr), addr);
-            }
-            else /*local load, comp event*/
-            {
-                /* treat a read/write to an address with
-                 * UNDEF thread as a local compute event */
-                stComp.updateReads(addr, 1);
-            }
+            isCommEdge = true;
+            stComm.addEdge(writer, eid, addr, size);
         }
-        catch(std::out_of_range &e)
+        else /*local load, comp event*/
         {
-            /* treat as a local event */
-            warn(e.what());
-            stComp.updateReads(addr, 1);
+            /* treat a read/write to an address with
+             * UNDEF thread as a local compute event */
+            stComp.updateReads(addr, size);
         }
-    }
+        return true;
+    });
 
     /* A situation when a singular memory event is both a communication edge
      * and a local thread read is rare and not robustly accounted for.
@@ -120,14 +121,7 @@ auto ThreadContextCompressed::onWrite(Addr start, Addr bytes) -> void
     stComp.incWrites();
     stComp.updateWrites(start, bytes);
 
-    try
-    {
-        shadow.updateWriter(start, bytes, tid, events);
-    }
-    catch(std::out_of_range &e)
-    {
-        warn(e.what());
-    }
+    shadow.updateWriter(start, bytes, tid, events);
 
     checkCompFlushLimit();
     stats.incWrites();
@@ -159,6 +153,18 @@ auto ThreadContextCompressed::onInstr() -> void
 }
 
 
+auto ThreadContextCompressed::onInstrs(unsigned n) -> void
+{
+    auto before = stats.getTotalInstrs();
+    stats.incInstrs(n);
+
+    /* same markers as onInstr, one per 2**N boundary crossed */
+    constexpr int limit = 1 << 12;
+    for (auto crossed = (stats.getTotalInstrs() >> 12) - (before >> 12); crossed > 0; --crossed)
+        logger->instrMarker(limit);
+}
+
+
 auto ThreadContextCompressed::checkCompFlushLimit() -> void
 {
     if ((stComp.writes >= primsPerStCompEv) || (stComp.reads >= primsPerStCompEv))
@@ -247,17 +253,17 @@ auto ThreadContextUncompressed::getStats() const -> PerThreadStats
 }
 
 
-auto ThreadContextUncompressed::onIop() -> void
+auto ThreadContextUncompressed::onIop(unsigned n) -> void
 {
-    stComp.incIOP();
-    stats.incIOPs();
+    stComp.incIOP(n);
+    stats.incIOPs(n);
 }
 
 
-auto ThreadContextUncompressed::onFlop() -> void
+auto ThreadContextUncompressed::onFlop(unsigned n) -> void
 {
-    stComp.incFLOP();
-    stats.incFLOPs();
+    stComp.incFLOP(n);
+    stats.incFLOPs(n);
 }
 
 
@@ -275,31 +281,19 @@ auto ThreadContextUncompressed::onRead(Addr start, Addr bytes) -> void
     TID producerTID{0};
     EID producerEID{0};
 
-    for (Addr i = 0; i < bytes; ++i)
+    /* only bytes up to the edge are read */
+    shadow.readRuns(start, bytes, tid,
+                    [&](Addr, Addr, TID writer, EID eid, bool isReader)
     {
-        Addr addr = start + i;
-        try
-        {
-            TID writer = shadow.getWriterTID(addr);
-            bool isReader= shadow.isReaderTID(addr, tid);
-
-            if (isReader == false)
-                shadow.updateReader(addr, 1, tid);
-
-            if /*comm edge*/((isReader == false) && (writer != tid) && (writer != SO_UNDEF))
-            {
-                isCommEdge = true;
-                producerTID = writer;
-                producerEID = shadow.getWriterEID(addr);
-                break;
-            }
-        }
-        catch(std::out_of_range &e)
+        if /*comm edge*/((isReader == false) && (writer != tid) && (writer != SO_UNDEF))
         {
-            /* XXX treat as a local event */
-            warn(e.what());
+            isCommEdge = true;
+            producerTID = writer;
+            producerEID = eid;
+            return false;
         }
-    }
+        return true;
+    });
 
     if (isCommEdge == true)
         commFlush(producerEID, producerTID, start, start+bytes-1);
@@ -314,14 +308,7 @@ auto ThreadContextUncompressed::onWrite(Addr start, Addr bytes) -> void
 {
     compFlush(STCompEventUncompressed::MemType::WRITE, start, start+bytes-1);
 
-    try
-    {
-        shadow.updateWriter(start, bytes, tid, events);
-    }
-    catch(std::out_of_range &e)
-    {
-        warn(e.what());
-    }
+    shadow.updateWriter(start, bytes, tid, events);
 
     stats.incWrites();
 }
@@ -350,6 +337,18 @@ auto ThreadContextUncompressed::onInstr() -> void
 }
 
 
+auto ThreadContextUncompressed::onInstrs(unsigned n) -> void
+{
+    auto before = stats.getTotalInstrs();
+    stats.incInstrs(n);
+
+    /* same markers as onInstr, one per 2**N boundary crossed */
+    constexpr int limit = 1 << 12;
+    for (auto crossed = (stats.getTotalInstrs() >> 12) - (before >> 12); crossed > 0; --crossed)
+        logger->instrMarker(limit);
+}
+
+
 auto ThreadContextUncompressed::compFlush(STCompEventUncompressed::MemType type,
                                           Addr start, Addr end) -> void
 {
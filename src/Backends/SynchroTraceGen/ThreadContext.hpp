@@ -4,11 +4,6 @@
 #include "STEvent.hpp"
 #include "STTypes.hpp"
 #include "TextLogger.hpp"
-
-/* DynamoRIO sometimes reports very high addresses.
- * For now, allow these addresses until we figure
- * out what to do with them */
-#define ALLOW_ADDRESS_OVERFLOW 1
 #include "STShadowMemory.hpp"
 
 /* XXX overflow builtin not in GCC <5.
@@ -35,8 +30,8 @@ class ThreadContext
   public:
     virtual ~ThreadContext() {}
     virtual auto getStats() const -> PerThreadStats = 0;
-    virtual auto onIop() -> void = 0;
-    virtual auto onFlop() -> void = 0;
+    virtual auto onIop(unsigned n) -> void = 0;
+    virtual auto onFlop(unsigned n) -> void = 0;
     virtual auto onRead(Addr start, Addr bytes) -> void = 0;
     virtual auto onWrite(Addr start, Addr bytes) -> void = 0;
     virtual auto onSync(unsigned char syncType, unsigned numArgs, Addr *syncArgs) -> void = 0;
@@ -44,8 +39,15 @@ class ThreadContext
      * the second argument is optional */
 
     virtual auto onInstr() -> void = 0;
+    virtual auto onInstrs(unsigned n) -> void = 0;
+    /* a basic block's worth of instructions at once */
     virtual auto flushAll() -> void = 0;
 
+    static auto releaseColdShadow() -> void;
+    /* drop shadow state that was not accessed recently */
+    static auto shadowStats() -> ShadowStats;
+    /* e.g. accesses past the shadowed address range, treated as local */
+
   protected:
     static STShadowMemory shadow; // Shadow memory is shared amongst all threads
 };
@@ -60,12 +62,13 @@ class ThreadContextCompressed : public ThreadContext
     ~ThreadContextCompressed();
 
     auto getStats() const -> PerThreadStats override final;
-    auto onIop() -> void override final;
-    auto onFlop() -> void override final;
+    auto onIop(unsigned n) -> void override final;
+    auto onFlop(unsigned n) -> void override final;
     auto onRead(Addr start, Addr bytes) -> void override final;
     auto onWrite(Addr start, Addr bytes) -> void override final;
     auto onSync(unsigned char syncType, unsigned numArgs, Addr *syncArgs) -> void override final;
     auto onInstr() -> void override final;
+    auto onInstrs(unsigned n) -> void override final;
     auto flushAll() -> void override final;
 
   private:
@@ -98,12 +101,13 @@ class ThreadContextUncompressed : public ThreadContext
     ~ThreadContextUncompressed();
 
     auto getStats() const -> PerThreadStats override final;
-    auto onIop() -> void override final;
-    auto onFlop() -> void override final;
+    auto onIop(unsigned n) -> void override final;
+    auto onFlop(unsigned n) -> void override final;
     auto onRead(Addr start, Addr bytes) -> void override final;
     auto onWrite(Addr start, Addr bytes) -> void override final;
     auto onSync(unsigned char syncType, unsigned numArgs, Addr *syncArgs) -> void override final;
     auto onInstr() -> void override final;
+    auto onInstrs(unsigned n) -> void override final;
     auto flushAll() -> void override final;
 
   private:
@@ -3,6 +3,12 @@
 
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include "SynchroTraceGen/STShadowMemory.hpp"
 
@@ -105,13 +111,450 @@ TEST_CASE("shadow memory tracks readers/writers", "[ShadowMemorySetGet]")
 
     SECTION("setting multiple readers")
     {
-        //TODO
+        STShadowMemory sm;
+        Addr addr = 0x1000;
+
+        /* past the inline readers */
+        for (TID tid : {0, 5, 22, 23, 64, 127})
+            sm.updateReader(addr, 8, tid);
+        for (TID tid = 0; tid < STGen::MAX_THREADS; ++tid)
+        {
+            bool expected = tid == 0 || tid == 5 || tid == 22 ||
+                            tid == 23 || tid == 64 || tid == 127;
+            REQUIRE(sm.isReaderTID(addr, tid) == expected);
+            REQUIRE(sm.isReaderTID(addr + 7, tid) == expected);
+            REQUIRE(sm.isReaderTID(addr + 8, tid) == false);
+        }
+
+        sm.updateWriter(addr, 4, 1, 1);
+        REQUIRE(sm.isReaderTID(addr, 127) == false);
+        REQUIRE(sm.isReaderTID(addr + 4, 127) == true);
+        sm.updateReader(addr, 1, 100);
+        REQUIRE(sm.isReaderTID(addr, 100) == true);
+        REQUIRE(sm.isReaderTID(addr, 64) == false);
     }
 
     SECTION("thread safety of setting/resetting multiple readers")
     {
-        //TODO
+        STShadowMemory sm;
+        /* Threads past INLINE_READERS share interned reader sets,
+         * and each thread also writes to its own new secondary maps */
+        const Addr shared = 0x7fff0000;
+        const TID first = 100;
+        const int threads = 4;
+        std::vector<int> mismatches(threads, 0);
+        /* Catch assertions are not thread safe */
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                Addr own = 0x10000000 + ((Addr)t << 24);
+                for (int i = 0; i < 1000; ++i)
+                {
+                    sm.updateReader(shared, 64, first + t);
+                    sm.updateWriter(own + i * 64, 64, first + t, i);
+                    mismatches[t] += sm.getWriterTID(own + i * 64) != first + t;
+                }
+            });
+        }
+        for (auto &w : workers)
+            w.join();
+
+        for (int t = 0; t < threads; ++t)
+        {
+            REQUIRE(mismatches[t] == 0);
+            REQUIRE(sm.isReaderTID(shared, first + t) == true);
+            REQUIRE(sm.isReaderTID(shared + 63, first + t) == true);
+            REQUIRE(sm.getWriterEID(0x10000000 + ((Addr)t << 24) + 999 * 64) == 999);
+        }
+    }
+}
+
+
+
+
+/* A load is a run of bytes with the same per-byte answers */
+using ByteState = std::tuple<Addr, TID, EID, bool>;
+
+auto readPerByte(STShadowMemory &sm, Addr start, ByteCount bytes, TID tid) -> std::vector<ByteState>
+{
+    /* the reference, one shadow lookup per query */
+    std::vector<ByteState> states;
+    for (Addr addr = start; addr < start + bytes; ++addr)
+    {
+        bool isReader = sm.isReaderTID(addr, tid);
+        states.emplace_back(addr, sm.getWriterTID(addr), sm.getWriterEID(addr), isReader);
+        if (isReader == false)
+            sm.updateReader(addr, 1, tid);
+    }
+    return states;
+}
+
+auto readRuns(STShadowMemory &sm, Addr start, ByteCount bytes, TID tid) -> std::vector<ByteState>
+{
+    std::vector<ByteState> states;
+    sm.readRuns(start, bytes, tid, [&](Addr addr, Addr size, TID writer, EID eid, bool isReader)
+    {
+        for (Addr i = 0; i < size; ++i)
+            states.emplace_back(addr + i, writer, eid, isReader);
+        return true;
+    });
+    return states;
+}
+
+struct MemOp
+{
+    bool load;
+    TID tid;
+    Addr addr;
+    ByteCount bytes;
+};
+
+auto loadMix(size_t ops, Addr base, Addr window, TID threads = 4) -> std::vector<MemOp>
+{
+    /* Roughly the access mix of the PARSEC kernels:
+     * mostly aligned word loads, a third stores, a few threads
+     * sharing a small working set, and the odd unaligned or vector access */
+    std::vector<MemOp> mix;
+    for (size_t i = 0; i < ops; ++i)
+    {
+        MemOp op;
+        op.load = rand() % 3 != 0;
+        op.tid = rand() % threads;
+        int kind = rand() % 10;
+        op.bytes = kind < 6 ? 8 : kind < 8 ? 4 : kind < 9 ? 1 << (rand() % 2) : 16 << (rand() % 2);
+        op.addr = base + (rand() % window & ~(Addr)(op.bytes - 1));
+        if (rand() % 50 == 0)
+            op.addr += 1 + rand() % 7;
+        mix.push_back(op);
+    }
+    return mix;
+}
+
+TEST_CASE("shadow memory ranges match per-byte queries", "[ShadowMemoryRange]")
+{
+    srand(time(NULL));
+
+    STShadowMemory reference;
+    STShadowMemory ranged;
+
+    /* straddle a secondary map boundary */
+    Addr base = reference.sm.sm_size - 2048;
+    EID eid = 0;
+    for (auto &op : loadMix(20000, base, 4096))
+    {
+        if (op.load)
+        {
+            REQUIRE(readPerByte(reference, op.addr, op.bytes, op.tid) ==
+                    readRuns(ranged, op.addr, op.bytes, op.tid));
+        }
+        else
+        {
+            ++eid;
+            for (Addr i = 0; i < op.bytes; ++i)
+                reference.updateWriter(op.addr + i, 1, op.tid, eid);
+            ranged.updateWriter(op.addr, op.bytes, op.tid, eid);
+        }
+    }
+
+    SECTION("a run stops when asked")
+    {
+        Addr addr = base + 4096;
+        ranged.updateWriter(addr, 4, 1, 10);
+        ranged.updateWriter(addr + 4, 4, 2, 11);
+
+        unsigned runs = 0;
+        ranged.forEachWriterRun(addr, 8, 3, [&](Addr, Addr size, TID writer, EID, bool)
+        {
+            ++runs;
+            REQUIRE(size == 4);
+            REQUIRE(writer == 1);
+            return false;
+        });
+        REQUIRE(runs == 1);
+    }
+
+    SECTION("a load only reads up to where it stops")
+    {
+        Addr addr = base + 4096;
+        ranged.updateWriter(addr, 4, 1, 10);
+        ranged.updateWriter(addr + 4, 4, 2, 11);
+
+        ranged.readRuns(addr, 8, 3, [&](Addr, Addr, TID writer, EID, bool)
+        {
+            return writer != 2;
+        });
+        REQUIRE(ranged.isReaderTID(addr + 3, 3) == true);
+        REQUIRE(ranged.isReaderTID(addr + 4, 3) == true);
+        REQUIRE(ranged.isReaderTID(addr + 5, 3) == false);
+    }
+}
+
+TEST_CASE("compact shadow state matches a plain model", "[ShadowMemoryCompact]")
+{
+    /* the state each byte had before it was packed */
+    struct Plain
+    {
+        TID writer{STGen::SO_UNDEF};
+        EID eid{0};
+        std::bitset<STGen::MAX_THREADS> readers;
+    };
+    std::vector<Plain> model(8192);
+
+    srand(time(NULL));
+    STShadowMemory sm;
+    Addr base = sm.sm.sm_size - 4096;
+    EID eid = 0;
+    for (auto &op : loadMix(50000, base, 4096, STGen::MAX_THREADS))
+    {
+        auto &first = model[op.addr - base];
+        if (op.load)
+        {
+            for (Addr i = 0; i < op.bytes; ++i)
+            {
+                auto &plain = (&first)[i];
+                REQUIRE(sm.getWriterTID(op.addr + i) == plain.writer);
+                REQUIRE(sm.getWriterEID(op.addr + i) == plain.eid);
+                REQUIRE(sm.isReaderTID(op.addr + i, op.tid) == plain.readers.test(op.tid));
+                plain.readers.set(op.tid);
+            }
+            sm.updateReader(op.addr, op.bytes, op.tid);
+        }
+        else
+        {
+            ++eid;
+            for (Addr i = 0; i < op.bytes; ++i)
+                (&first)[i] = Plain{op.tid, eid, {}};
+            sm.updateWriter(op.addr, op.bytes, op.tid, eid);
+        }
+    }
+}
+
+TEST_CASE("shadow maps are committed on demand", "[ShadowMemoryMmap]")
+{
+    STShadowMemory sm;
+    const Addr page = sysconf(_SC_PAGESIZE);
+    REQUIRE(sm.sm.mappedBytes() == 0);
+    REQUIRE(sm.sm.touchedBytes() == 0);
+
+    Addr addr = 0x7fff0000;
+    sm.updateWriter(addr, 8, 1, 1);
+    sm.updateReader(addr, 8, 100);
+    REQUIRE(sm.sm.mappedBytes() == sm.sm.sm_bytes);
+    REQUIRE(sm.sm.touchedBytes() >= page);
+    REQUIRE(sm.sm.touchedBytes() <= 2 * page);
+
+    SECTION("recently used maps are kept")
+    {
+        REQUIRE(sm.releaseCold() == 0);
+        REQUIRE(sm.getWriterTID(addr) == 1);
+        REQUIRE(sm.isReaderTID(addr, 100) == true);
+    }
+
+    SECTION("cold maps revert to the initial state")
+    {
+        sm.releaseCold();
+        REQUIRE(sm.releaseCold() == sm.sm.sm_bytes);
+        REQUIRE(sm.sm.touchedBytes() == 0);
+        REQUIRE(sm.sm.mappedBytes() == sm.sm.sm_bytes);
+
+        REQUIRE(sm.getWriterTID(addr) == STGen::SO_UNDEF);
+        REQUIRE(sm.getWriterEID(addr) == 0);
+        REQUIRE(sm.isReaderTID(addr, 100) == false);
+    }
+}
+
+TEST_CASE("shadow memory covers the user address space", "[ShadowMemoryAddressSpace]")
+{
+    STShadowMemory sm;
+
+    SECTION("48 and 57 bit addresses are shadowed")
+    {
+        for (Addr addr : {(Addr)0x7ffffffff000, (Addr)0xfffffffffff000, (Addr)1 << 56})
+        {
+            sm.updateWriter(addr - 4, 8, 3, 7);
+            REQUIRE(sm.getWriterTID(addr - 4) == 3);
+            REQUIRE(sm.getWriterTID(addr + 3) == 3);
+            REQUIRE(sm.getWriterEID(addr + 3) == 7);
+            REQUIRE(sm.getWriterTID(addr + 4) == STGen::SO_UNDEF);
+        }
+        REQUIRE(sm.outOfRange() == 0);
+    }
+
+    SECTION("addresses past the range are counted, and never written")
+    {
+        Addr addr = 0xffffffffff600000; // vsyscall page
+        sm.updateWriter(addr, 8, 3, 7);
+        REQUIRE(sm.getWriterTID(addr) == STGen::SO_UNDEF);
+        REQUIRE(sm.isReaderTID(addr, 3) == false);
+
+        unsigned runs = 0;
+        sm.forEachWriterRun(addr, 8, 4, [&](Addr, Addr size, TID writer, EID, bool isReader)
+        {
+            ++runs;
+            REQUIRE(size == 8);
+            REQUIRE(writer == STGen::SO_UNDEF);
+            REQUIRE(isReader == false);
+            return true;
+        });
+        REQUIRE(runs == 1);
+        REQUIRE(sm.outOfRange() == 4);
     }
 }
 
+using ShadowObject = STShadowMemory::ShadowObject;
+template <unsigned TLB_ENTRIES>
+using TLBShadowMemory = ShadowMemory<ShadowObject, 57, 18, TLB_ENTRIES>;
 
+TEST_CASE("shadow map lookups are cached", "[ShadowMemoryTLB]")
+{
+    /* stack, heap, and globals are in different secondary maps */
+    const Addr regions[] = {0x7ffffffde000, 0x555555756000, 0x601000};
+
+    SECTION("interleaved regions stay cached")
+    {
+        TLBShadowMemory<16> sm;
+        for (int i = 0; i < 100; ++i)
+            for (Addr base : regions)
+                sm[base + i].setLastWriter(1);
+        REQUIRE(sm.tlbHits() == 300 - 3);
+        REQUIRE(sm.tlbHitRate() == Approx(297.0 / 300));
+        for (Addr base : regions)
+            REQUIRE(sm[base + 99].lastWriter() == 1);
+    }
+
+    SECTION("a single entry only caches the last map")
+    {
+        TLBShadowMemory<1> sm;
+        for (int i = 0; i < 100; ++i)
+            for (Addr base : regions)
+                sm[base + i].setLastWriter(1);
+        REQUIRE(sm.tlbHits() == 0);
+    }
+
+    SECTION("conflicting maps evict each other")
+    {
+        TLBShadowMemory<16> sm;
+        Addr a = 0x7ffffffde000;
+        Addr b = a + ((Addr)16 << sm.sm_bits);
+        for (int i = 0; i < 10; ++i)
+        {
+            sm[a + i].setLastWriter(1);
+            sm[b + i].setLastWriter(2);
+        }
+        REQUIRE(sm.tlbHits() == 0);
+        REQUIRE(sm[a].lastWriter() == 1);
+        REQUIRE(sm[b].lastWriter() == 2);
+    }
+
+    SECTION("released maps are looked up again")
+    {
+        TLBShadowMemory<16> sm;
+        sm[regions[0]].setLastWriter(1);
+        sm.releaseCold([](ShadowObject*, Addr) {});
+        sm.releaseCold([](ShadowObject*, Addr) {});
+        REQUIRE(sm[regions[0]].lastWriter() == STGen::SO_UNDEF);
+        REQUIRE(sm.tlbHits() == 0);
+    }
+}
+
+auto commPerByte(STShadowMemory &sm, Addr start, ByteCount bytes, TID tid) -> Addr
+{
+    /* what STGen did for each load before ranges */
+    Addr comm = 0;
+    for (Addr addr = start; addr < start + bytes; ++addr)
+    {
+        TID writer = sm.getWriterTID(addr);
+        bool isReader = sm.isReaderTID(addr, tid);
+        if (isReader == false)
+            sm.updateReader(addr, 1, tid);
+        if (isReader == false && writer != tid && writer != STGen::SO_UNDEF)
+            comm += sm.getWriterEID(addr) != 0;
+    }
+    return comm;
+}
+
+auto commRuns(STShadowMemory &sm, Addr start, ByteCount bytes, TID tid) -> Addr
+{
+    Addr comm = 0;
+    sm.readRuns(start, bytes, tid, [&](Addr, Addr size, TID writer, EID eid, bool isReader)
+    {
+        if (isReader == false && writer != tid && writer != STGen::SO_UNDEF)
+            comm += (eid != 0) * size;
+        return true;
+    });
+    return comm;
+}
+
+TEST_CASE("shadow memory range benchmark", "[.][ShadowMemoryBench]")
+{
+    /* Not run by default; run with the tag to compare */
+    auto mix = loadMix(4000000, 0x7fff0000, 1 << 20);
+
+    auto time = [&](const char *name, Addr (*read)(STShadowMemory&, Addr, ByteCount, TID))
+    {
+        STShadowMemory sm;
+        EID eid = 0;
+        Addr comm = 0;
+        /* warm up, so secondary maps are already allocated */
+        for (auto &op : mix)
+            sm.updateWriter(op.addr, op.bytes, op.tid, ++eid);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (auto &op : mix)
+        {
+            if (op.load)
+                comm += read(sm, op.addr, op.bytes, op.tid);
+            else
+                sm.updateWriter(op.addr, op.bytes, op.tid, ++eid);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+        std::cout << name << ": " << elapsed.count() / mix.size() << " ns/op, "
+                  << comm << " comm bytes" << std::endl;
+        return comm;
+    };
+
+    Addr perByte = time("per-byte", commPerByte);
+    Addr ranges = time("ranges  ", commRuns);
+    REQUIRE(perByte == ranges);
+}
+
+template <unsigned TLB_ENTRIES>
+auto timeLookups(const std::vector<Addr> &addrs) -> double
+{
+    TLBShadowMemory<TLB_ENTRIES> sm;
+    /* warm up, so secondary maps are already allocated */
+    for (Addr addr : addrs)
+        sm[addr].setLastWriter(1);
+
+    Addr writers = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < 10; ++rep)
+        for (Addr addr : addrs)
+            writers += sm[addr].lastWriter();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    REQUIRE(writers == 10 * addrs.size());
+    std::cout << TLB_ENTRIES << " entries: " << elapsed.count() / (10 * addrs.size())
+              << " ns/lookup, " << sm.tlbHitRate() << " hit rate" << std::endl;
+    return elapsed.count();
+}
+
+TEST_CASE("shadow map lookup cache benchmark", "[.][ShadowMemoryTLBBench]")
+{
+    /* Not run by default; run with the tag to compare.
+     * Per-byte lookups interleaved between the stack, a few heap arrays,
+     * and globals, as in a loop copying between buffers */
+    const Addr regions[] = {0x7ffffffde000, 0x555555756000, 0x7ffff7a00000,
+                            0x7fffe0000000, 0x601000};
+    std::vector<Addr> addrs;
+    for (int i = 0; i < 2000000; ++i)
+    {
+        Addr base = regions[rand() % 5];
+        addrs.push_back(base + rand() % (1 << 16));
+    }
+
+    timeLookups<1>(addrs);
+    timeLookups<4>(addrs);
+    timeLookups<16>(addrs);
+}
@@ -2,6 +2,88 @@
 #include "PrismLog.hpp"
 #include <algorithm>
 
+auto BackendIface::onEvents(const EventBuffer &buf,
+                            const GetNameBase &nameBase) -> void
+{
+    if (buf.encoding == PRISM_EVENTS_COLUMNS)
+        dispatchColumns(buf, nameBase);
+    else
+        dispatchPacked(buf, nameBase);
+}
+
+
+auto BackendIface::dispatchPacked(const EventBuffer &buf,
+                                  const GetNameBase &nameBase) -> void
+{
+    for (decltype(buf.used) i = 0; i < buf.used; ++i)
+    {
+        const PrismEvVariant &ev = buf.events[i];
+
+        switch (ev.tag)
+        {
+        case EvTagEnum::PRISM_MEM_TAG:
+            onMemEv({ev.mem});
+            break;
+        case EvTagEnum::PRISM_COMP_TAG:
+            onCompEv({ev.comp});
+            break;
+        case EvTagEnum::PRISM_SYNC_TAG:
+            onSyncEv({ev.sync});
+            break;
+        case EvTagEnum::PRISM_CXT_TAG:
+            onCxtEv({ev.cxt, nameBase});
+            break;
+        case EvTagEnum::PRISM_CF_TAG:
+            onCFEv(ev.cf);
+            break;
+        default:
+            unhandledEvent();
+        }
+    }
+}
+
+
+auto BackendIface::dispatchColumns(const EventBuffer &buf,
+                                   const GetNameBase &nameBase) -> void
+{
+    const EvTag *tags = prismColumnTags(&buf);
+    const PrismMemSlot *mem = prismColumnMem(&buf);
+    const PrismCompSlot *comp = prismColumnComp(&buf);
+    const PrismSyncSlot *sync = prismColumnSync(&buf);
+    const PrismCxtSlot *cxt = prismColumnCxt(&buf);
+    const PrismCFSlot *cf = prismColumnCF(&buf);
+
+    for (decltype(buf.used) i = 0; i < buf.used; ++i)
+    {
+        switch (tags[i])
+        {
+        case EvTagEnum::PRISM_MEM_TAG:
+            onMemEv({prismMemFromSlot(mem++)});
+            break;
+        case EvTagEnum::PRISM_COMP_TAG:
+            onCompEv({prismCompFromSlot(comp++)});
+            break;
+        case EvTagEnum::PRISM_SYNC_TAG:
+            onSyncEv({prismSyncFromSlot(sync++)});
+            break;
+        case EvTagEnum::PRISM_CXT_TAG:
+            onCxtEv({prismCxtFromSlot(cxt++), nameBase});
+            break;
+        case EvTagEnum::PRISM_CF_TAG:
+            onCFEv(prismCFFromSlot(cf++));
+            break;
+        default:
+            unhandledEvent();
+        }
+    }
+}
+
+
+auto BackendIface::unhandledEvent() -> void
+{
+    PrismLog::fatal("Received unhandled event in " __FILE__);
+}
+
 auto BackendFactory::create(ToolName name, Args args) const -> Backend
 {
     std::transform(name.begin(), name.end(), name.begin(), ::tolower);
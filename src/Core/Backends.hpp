@@ -2,6 +2,7 @@
 #define PRISM_BACKEND_H
 
 #include "Primitive.h"
+#include "EventBuffer.h"
 #include <string>
 #include <vector>
 #include <functional>
@@ -17,6 +18,118 @@ class BackendIface
     virtual auto onSyncEv(const prism::SyncEvent &) -> void {}
     virtual auto onCxtEv(const prism::CxtEvent &) -> void {}
     virtual auto onCFEv(const PrismCFEv &) -> void {}
+
+    virtual auto onEvents(const EventBuffer &buf,
+                          const GetNameBase &nameBase) -> void;
+    /* Batch interface: the Prism core hands over an entire buffer at once.
+     * The default implementation dispatches each event to the
+     * per-event hooks above, one virtual call per event,
+     * in stream order for either EventBuffer encoding.
+     * Backends that care about throughput should derive from
+     * BatchedBackendIface instead of overriding this by hand.
+     *
+     * A backend that only needs memory events can override this and,
+     * for PRISM_EVENTS_COLUMNS buffers, scan prismColumnMem(&buf)
+     * (prismColumns(&buf)->mem entries) without looking at the tags. */
+
+  protected:
+    [[noreturn]] static auto unhandledEvent() -> void;
+
+  private:
+    auto dispatchPacked(const EventBuffer &buf, const GetNameBase &nameBase) -> void;
+    auto dispatchColumns(const EventBuffer &buf, const GetNameBase &nameBase) -> void;
+};
+
+
+template <typename Derived>
+class BatchedBackendIface : public BackendIface
+{
+    /* CRTP adapter that devirtualizes per-event dispatch.
+     * The per-event hooks are called with qualified names on the
+     * concrete type, so the compiler can inline them into the loop.
+     * Only one virtual call is made per buffer.
+     *
+     * Derived classes that keep their hooks private must befriend
+     * BatchedBackendIface<Derived>.
+     * Hooks not overridden in Derived fall back to BackendIface's no-ops. */
+
+  public:
+    virtual auto onEvents(const EventBuffer &buf,
+                          const GetNameBase &nameBase) -> void override final
+    {
+        if (buf.encoding == PRISM_EVENTS_COLUMNS)
+            dispatchColumns(buf, nameBase);
+        else
+            dispatchPacked(buf, nameBase);
+    }
+
+  private:
+    auto dispatchPacked(const EventBuffer &buf, const GetNameBase &nameBase) -> void
+    {
+        Derived &self = static_cast<Derived&>(*this);
+
+        for (decltype(buf.used) i = 0; i < buf.used; ++i)
+        {
+            const PrismEvVariant &ev = buf.events[i];
+
+            switch (ev.tag)
+            {
+            case EvTagEnum::PRISM_MEM_TAG:
+                self.Derived::onMemEv({ev.mem});
+                break;
+            case EvTagEnum::PRISM_COMP_TAG:
+                self.Derived::onCompEv({ev.comp});
+                break;
+            case EvTagEnum::PRISM_SYNC_TAG:
+                self.Derived::onSyncEv({ev.sync});
+                break;
+            case EvTagEnum::PRISM_CXT_TAG:
+                self.Derived::onCxtEv({ev.cxt, nameBase});
+                break;
+            case EvTagEnum::PRISM_CF_TAG:
+                self.Derived::onCFEv(ev.cf);
+                break;
+            default:
+                unhandledEvent();
+            }
+        }
+    }
+
+    auto dispatchColumns(const EventBuffer &buf, const GetNameBase &nameBase) -> void
+    {
+        Derived &self = static_cast<Derived&>(*this);
+
+        const EvTag *tags = prismColumnTags(&buf);
+        const PrismMemSlot *mem = prismColumnMem(&buf);
+        const PrismCompSlot *comp = prismColumnComp(&buf);
+        const PrismSyncSlot *sync = prismColumnSync(&buf);
+        const PrismCxtSlot *cxt = prismColumnCxt(&buf);
+        const PrismCFSlot *cf = prismColumnCF(&buf);
+
+        for (decltype(buf.used) i = 0; i < buf.used; ++i)
+        {
+            switch (tags[i])
+            {
+            case EvTagEnum::PRISM_MEM_TAG:
+                self.Derived::onMemEv({prismMemFromSlot(mem++)});
+                break;
+            case EvTagEnum::PRISM_COMP_TAG:
+                self.Derived::onCompEv({prismCompFromSlot(comp++)});
+                break;
+            case EvTagEnum::PRISM_SYNC_TAG:
+                self.Derived::onSyncEv({prismSyncFromSlot(sync++)});
+                break;
+            case EvTagEnum::PRISM_CXT_TAG:
+                self.Derived::onCxtEv({prismCxtFromSlot(cxt++), nameBase});
+                break;
+            case EvTagEnum::PRISM_CF_TAG:
+                self.Derived::onCFEv(prismCFFromSlot(cf++));
+                break;
+            default:
+                unhandledEvent();
+            }
+        }
+    }
 };
 
 using ToolName = std::string;
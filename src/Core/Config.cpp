@@ -1,5 +1,6 @@
 #include "Config.hpp"
 #include <numeric>
+#include <set>
 
 namespace prism
 {
@@ -30,22 +31,52 @@ auto Config::parseCommandLine(int argc, char* argv[]) -> Config&
 
     _threads = parser.threads();
     _timed = parser.timed();
+    _stagingBuffers = parser.stagingBuffers();
+    _mergeStreams = parser.mergeStreams();
+    _fanoutThreads = parser.fanoutThreads();
+    _stats = parser.stats();
+    _ipc.transport = parser.ipcTransport();
+    _ipc.encoding = parser.ipcEncoding();
+    _ipc.buffers = parser.ipcBuffers();
+    _ipc.bufferEvents = parser.ipcBufferEvents();
+    _ipc.hugePages = parser.ipcHugePages();
 
     auto execArgs = parser.executable();
     executableName = std::accumulate(std::next(execArgs.begin()), execArgs.end(), std::string{execArgs.front()},
                                      [](const std::string &a, const std::string &b) { return (a + " " + b); });
 
-    std::vector<std::string> beArgs;
-    std::tie(backendName, beArgs) = parser.backend();
-    _backend = beFactory.create(backendName, beArgs);
+    /* the frontend must provide what any of the backends require */
+    std::set<std::string> beNames;
+    auto beReqs = initCaps();
+    for (const auto &tool : parser.backends())
+    {
+        if (beNames.insert(tool.first).second == false)
+            PrismLog::fatal("Backend specified more than once: " + tool.first);
+
+        _backends.push_back(beFactory.create(tool.first, tool.second));
+        beReqs = combineReqs(beReqs, _backends.back().caps);
+        backendName += (backendName.empty() ? "" : ", ") + tool.first;
+    }
 
     std::vector<std::string> feArgs;
     std::tie(frontendName, feArgs) = parser.frontend();
-    _startFrontend = feFactory.create(frontendName, execArgs, feArgs, _threads, _backend.caps);
+    _startFrontend = feFactory.create(frontendName, execArgs, feArgs, _threads, beReqs, _ipc);
 
     parsed = true;
 
     return *this;
 }
 
+
+auto Config::ipcPrintable() const -> std::string
+{
+    assert(parsed);
+    return (_ipc.transport == IpcTransport::futex ? "futex" : "fifo") +
+           std::string(_ipc.encoding == EventEncoding::columns ? ", columns" :
+                       _ipc.encoding == EventEncoding::compact ? ", compact" : ", packed") +
+           std::string(", ") + std::to_string(_ipc.buffers) + " buffers" +
+           std::string(" x ") + std::to_string(_ipc.bufferEvents) + " events" +
+           (_ipc.hugePages ? ", huge pages" : "");
+}
+
 }; //end namespace prism
@@ -23,10 +23,16 @@ class Config
 
     auto timed() const { return _timed;   }
     auto threads() const { return _threads; }
-    auto backend() const { return _backend; }
+    auto stagingBuffers() const { return _stagingBuffers; }
+    auto mergeStreams() const { return _mergeStreams; }
+    auto fanoutThreads() const { return _fanoutThreads; }
+    auto stats() const { return _stats; }
+    auto ipc() const { return _ipc; }
+    auto backends() const { return _backends; }
     auto frontend() const { return _frontend; }
     auto startFrontend() const { return _startFrontend; }
     auto threadsPrintable() const { assert(parsed); return std::to_string(_threads); }
+    auto ipcPrintable() const -> std::string;
     auto backendPrintable() const { assert(parsed); return backendName; }
     auto frontendPrintable() const { assert(parsed); return frontendName; }
     auto executablePrintable() const { assert(parsed); return executableName; }
@@ -38,7 +44,12 @@ class Config
 
     bool _timed;
     int _threads;
-    Backend _backend;
+    unsigned _stagingBuffers;
+    bool _mergeStreams;
+    bool _fanoutThreads;
+    StatsConfig _stats;
+    IpcConfig _ipc;
+    std::vector<Backend> _backends;
     Frontend _frontend;
     FrontendStarterWrapper _startFrontend;
 
@@ -3,9 +3,18 @@
 
 #include "Primitive.h"
 #include <stdlib.h>
+#include <string.h>
 
 #define PRISM_NAMES_BUFFER_SIZE (1UL << 12)
 #define PRISM_EVENTS_BUFFER_SIZE (1UL << 12)
+/* Default capacities. The actual capacity of a buffer is decided
+ * by whoever allocates it, e.g. from the shared memory IPC header,
+ * so the trailing arrays below are flexible. */
+
+#define PRISM_EVENTS_PACKED  (0u)
+#define PRISM_EVENTS_COLUMNS (1u)
+#define PRISM_EVENTS_COMPACT (2u)
+/* EventBuffer encodings, see below */
 
 #ifdef __cplusplus
 #include <memory>
@@ -13,6 +22,13 @@ extern "C" {
 #else
 typedef struct PrismEvVariant PrismEvVariant;
 typedef struct EventBuffer EventBuffer;
+typedef struct EventColumns EventColumns;
+typedef struct PrismColumnsLayout PrismColumnsLayout;
+typedef struct PrismMemSlot PrismMemSlot;
+typedef struct PrismCompSlot PrismCompSlot;
+typedef struct PrismCFSlot PrismCFSlot;
+typedef struct PrismCxtSlot PrismCxtSlot;
+typedef struct PrismSyncSlot PrismSyncSlot;
 typedef struct NameBuffer NameBuffer;
 typedef struct TimestampBuffer TimestampBuffer;
 #endif
@@ -34,12 +50,271 @@ struct PrismEvVariant
 
 struct EventBuffer
 {
-    /* Prism core event primitives */
+    /* Prism core event primitives.
+     *
+     * 'encoding' selects how the trailing storage is laid out:
+     * - PRISM_EVENTS_PACKED: 'events' holds 'used' variants in stream order.
+     * - PRISM_EVENTS_COLUMNS: the storage holds an EventColumns header,
+     *   one tag per event in stream order, and a naturally aligned array
+     *   of payloads per event type. The n-th event with a given tag is the
+     *   n-th entry in that tag's column, so walking the tags with a cursor
+     *   per column recovers the original order.
+     *   Use prismColumns*() below instead of 'events'.
+     * - PRISM_EVENTS_COMPACT: the storage holds a delta/varint byte stream,
+     *   see EventCodec.h. Only used across shared memory; frontends decode
+     *   it before handing the buffer to a backend.
+     *
+     * 'capacity' is the number of events the storage was sized for;
+     * in the column encoding every column can hold that many, and the
+     * compact encoding takes the same space as the packed encoding */
 
     size_t used;
-    PrismEvVariant events[PRISM_EVENTS_BUFFER_SIZE];
+    uint32_t encoding;
+    uint32_t capacity;
+    PrismEvVariant events[];
+};
+
+
+/* Column encoding payloads.
+ * Same fields as the packed primitives, reordered and unpacked
+ * so that every field is naturally aligned in an array */
+
+struct PrismMemSlot
+{
+    PtrVal    begin_addr;
+    ByteCount size;
+    MemType   type;
+};
+
+struct PrismCompSlot
+{
+    CompCostType type;
+    CompArity    arity;
+    CompCostOp   op;
+    uint8_t      size;
 };
 
+struct PrismCFSlot
+{
+    CFType type;
+};
+
+struct PrismCxtSlot
+{
+    union
+    {
+        PtrVal id;
+        char*  name;
+        struct
+        {
+            uint32_t idx;
+            uint32_t len;
+        };
+    };
+    CxtType type;
+};
+
+struct PrismSyncSlot
+{
+    SyncID   data[2];
+    SyncType type;
+};
+
+struct EventColumns
+{
+    /* Entries used in each column.
+     * Their sum is the EventBuffer's 'used' */
+
+    uint32_t mem;
+    uint32_t comp;
+    uint32_t cf;
+    uint32_t cxt;
+    uint32_t sync;
+};
+
+struct PrismColumnsLayout
+{
+    /* byte offsets from the start of the EventBuffer */
+    size_t tags, mem, comp, cf, cxt, sync;
+    size_t total;
+};
+
+
+static inline size_t prismColumnAlign(size_t bytes)
+{
+    /* start every column on its own cache line */
+    return (bytes + 63) & ~(size_t)63;
+}
+
+
+static inline PrismColumnsLayout prismColumnsLayout(uint32_t capacity)
+{
+    PrismColumnsLayout layout;
+    layout.tags  = prismColumnAlign(sizeof(EventBuffer) + sizeof(EventColumns));
+    layout.mem   = prismColumnAlign(layout.tags + capacity * sizeof(EvTag));
+    layout.comp  = prismColumnAlign(layout.mem  + capacity * sizeof(PrismMemSlot));
+    layout.cf    = prismColumnAlign(layout.comp + capacity * sizeof(PrismCompSlot));
+    layout.cxt   = prismColumnAlign(layout.cf   + capacity * sizeof(PrismCFSlot));
+    layout.sync  = prismColumnAlign(layout.cxt  + capacity * sizeof(PrismCxtSlot));
+    layout.total = prismColumnAlign(layout.sync + capacity * sizeof(PrismSyncSlot));
+    return layout;
+}
+
+
+static inline size_t prismEventBufferSize(uint32_t encoding, uint32_t capacity)
+{
+    /* Bytes needed for an EventBuffer that holds 'capacity' events */
+    if (encoding == PRISM_EVENTS_COLUMNS)
+        return prismColumnsLayout(capacity).total;
+    else
+        return sizeof(EventBuffer) + capacity * sizeof(PrismEvVariant);
+}
+
+
+#define PRISM_COLUMN(buf, column, type) \
+    ((type*)((char*)(buf) + prismColumnsLayout((buf)->capacity).column))
+
+static inline EventColumns*  prismColumns(const EventBuffer *buf)
+{ return (EventColumns*)buf->events; }
+static inline EvTag*         prismColumnTags(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, tags, EvTag); }
+static inline PrismMemSlot*  prismColumnMem(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, mem, PrismMemSlot); }
+static inline PrismCompSlot* prismColumnComp(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, comp, PrismCompSlot); }
+static inline PrismCFSlot*   prismColumnCF(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, cf, PrismCFSlot); }
+static inline PrismCxtSlot*  prismColumnCxt(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, cxt, PrismCxtSlot); }
+static inline PrismSyncSlot* prismColumnSync(const EventBuffer *buf)
+{ return PRISM_COLUMN(buf, sync, PrismSyncSlot); }
+
+#undef PRISM_COLUMN
+
+
+static inline void prismColumnsReset(EventBuffer *buf)
+{
+    buf->used = 0;
+    memset(prismColumns(buf), 0, sizeof(EventColumns));
+}
+
+
+static inline PrismMemEv prismMemFromSlot(const PrismMemSlot *slot)
+{
+    PrismMemEv ev;
+    ev.begin_addr = slot->begin_addr;
+    ev.size       = slot->size;
+    ev.type       = slot->type;
+    return ev;
+}
+
+static inline PrismCompEv prismCompFromSlot(const PrismCompSlot *slot)
+{
+    PrismCompEv ev;
+    ev.type  = slot->type;
+    ev.arity = slot->arity;
+    ev.op    = slot->op;
+    ev.size  = slot->size;
+    return ev;
+}
+
+static inline PrismCFEv prismCFFromSlot(const PrismCFSlot *slot)
+{
+    PrismCFEv ev;
+    ev.type = slot->type;
+    return ev;
+}
+
+static inline PrismCxtEv prismCxtFromSlot(const PrismCxtSlot *slot)
+{
+    PrismCxtEv ev;
+    ev.type = slot->type;
+    ev.id   = slot->id;
+    return ev;
+}
+
+static inline PrismSyncEv prismSyncFromSlot(const PrismSyncSlot *slot)
+{
+    PrismSyncEv ev;
+    ev.type    = slot->type;
+    ev.data[0] = slot->data[0];
+    ev.data[1] = slot->data[1];
+    return ev;
+}
+/* Convert a column entry back to the packed primitive
+ * that the backend event wrappers expect */
+
+
+static inline void prismColumnsUnpack(EventBuffer *dst, const EventBuffer *src)
+{
+    /* Rewrite the column encoded 'src' as packed events in stream order.
+     * 'dst' must hold at least prismEventBufferSize(PRISM_EVENTS_PACKED, src->used) bytes */
+
+    const EvTag *tags = prismColumnTags(src);
+    const PrismMemSlot *mem = prismColumnMem(src);
+    const PrismCompSlot *comp = prismColumnComp(src);
+    const PrismCFSlot *cf = prismColumnCF(src);
+    const PrismCxtSlot *cxt = prismColumnCxt(src);
+    const PrismSyncSlot *sync = prismColumnSync(src);
+    size_t i;
+
+    dst->used     = src->used;
+    dst->encoding = PRISM_EVENTS_PACKED;
+    dst->capacity = src->used;
+
+    for (i = 0; i < src->used; ++i)
+    {
+        PrismEvVariant *ev = &dst->events[i];
+        ev->tag = tags[i];
+        switch (tags[i])
+        {
+        case PRISM_MEM_TAG:
+            ev->mem = prismMemFromSlot(mem++);
+            break;
+        case PRISM_COMP_TAG:
+            ev->comp = prismCompFromSlot(comp++);
+            break;
+        case PRISM_CF_TAG:
+            ev->cf = prismCFFromSlot(cf++);
+            break;
+        case PRISM_CXT_TAG:
+            ev->cxt = prismCxtFromSlot(cxt++);
+            break;
+        case PRISM_SYNC_TAG:
+            ev->sync = prismSyncFromSlot(sync++);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+static inline void prismEventBufferCopy(EventBuffer *dst, const EventBuffer *src)
+{
+    /* Copy only the used part of 'src' into 'dst', which must be at least
+     * prismEventBufferSize(src->encoding, src->capacity) bytes */
+
+    dst->used     = src->used;
+    dst->encoding = src->encoding;
+    dst->capacity = src->capacity;
+
+    if (src->encoding != PRISM_EVENTS_COLUMNS)
+    {
+        memcpy(dst->events, src->events, src->used * sizeof(PrismEvVariant));
+        return;
+    }
+
+    const EventColumns *cols = prismColumns(src);
+    *prismColumns(dst) = *cols;
+    memcpy(prismColumnTags(dst), prismColumnTags(src), src->used * sizeof(EvTag));
+    memcpy(prismColumnMem(dst),  prismColumnMem(src),  cols->mem  * sizeof(PrismMemSlot));
+    memcpy(prismColumnComp(dst), prismColumnComp(src), cols->comp * sizeof(PrismCompSlot));
+    memcpy(prismColumnCF(dst),   prismColumnCF(src),   cols->cf   * sizeof(PrismCFSlot));
+    memcpy(prismColumnCxt(dst),  prismColumnCxt(src),  cols->cxt  * sizeof(PrismCxtSlot));
+    memcpy(prismColumnSync(dst), prismColumnSync(src), cols->sync * sizeof(PrismSyncSlot));
+}
+
 struct TimestampBuffer
 {
     /* Timestamps are an optional feature to order events.
@@ -55,7 +330,7 @@ struct TimestampBuffer
      * should always match */
 
     size_t used;
-    uint64_t timestamps[PRISM_EVENTS_BUFFER_SIZE];
+    uint64_t timestamps[];
 };
 
 struct NameBuffer
@@ -66,7 +341,7 @@ struct NameBuffer
      * corresponding memory arena. */
 
     size_t used;
-    char names[PRISM_NAMES_BUFFER_SIZE];
+    char names[];
 };
 
 
@@ -0,0 +1,442 @@
+#ifndef PRISM_EVENTCODEC_H
+#define PRISM_EVENTCODEC_H
+
+#include "EventBuffer.h"
+
+/*
+ * Compact wire encoding for EventBuffers (PRISM_EVENTS_COMPACT)
+ *
+ * Consecutive memory addresses and instruction addresses are
+ * highly correlated, so instead of a full PtrVal per event, the frontend
+ * writes each event as a byte stream:
+ *
+ *   byte 0        low 3 bits: EvTag
+ *                 high 5 bits: event specific short fields
+ *   [escapes]     short fields that did not fit, as varints
+ *   [payload]     varints, see below
+ *
+ *   MEM   short:   type (2 bits), log2(size) (3 bits)
+ *         payload: zigzag(addr - previous memory address)
+ *   COMP  short:   type (2 bits), arity (3 bits)
+ *         payload: op | size << 8
+ *   CF    short:   type (5 bits)
+ *   CXT   short:   type (5 bits)
+ *         payload: PRISM_CXT_INSTR: zigzag(id - previous instruction address)
+ *                  PRISM_CXT_FUNC_*: idx, len
+ *                  otherwise: id
+ *   SYNC  short:   type (5 bits)
+ *         payload: zigzag(data[0]), zigzag(data[1])
+ *
+ * A short field with all bits set is an escape: the actual value follows
+ * byte 0 as a varint. Varints are unsigned LEB128.
+ *
+ * The previous addresses start at 0 in every buffer, so each buffer
+ * decodes on its own. The encoding is lossless.
+ *
+ * The storage after the EventBuffer header holds a CompactEvents block.
+ * A compact buffer takes the same space as a packed buffer of the same
+ * capacity, but typically fits several times as many events.
+ * Only the external tool and the shared memory frontend see this encoding;
+ * the frontend decodes each buffer back into packed events on acquire.
+ *
+ * Everything here is header-only and libc-free so that Valgrind tools
+ * can use it.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#else
+typedef struct CompactEvents CompactEvents;
+typedef struct PrismEncoder PrismEncoder;
+#endif
+
+#define PRISM_VARINT_MAX_BYTES (10)
+#define PRISM_COMPACT_MAX_EVENT_BYTES (1 + 2 + 3 + 2 * PRISM_VARINT_MAX_BYTES)
+/* Worst case for a single event. An encoder must have at least
+ * this many bytes left before encoding another event */
+
+struct CompactEvents
+{
+    uint64_t bytes;
+    /* length of the encoded stream */
+
+    uint8_t data[];
+};
+
+
+static inline CompactEvents* prismCompact(const EventBuffer *buf)
+{
+    return (CompactEvents*)buf->events;
+}
+
+
+static inline uint64_t prismCompactCapacity(const EventBuffer *buf)
+{
+    /* bytes available for the encoded stream */
+    return prismEventBufferSize(PRISM_EVENTS_COMPACT, buf->capacity) -
+           sizeof(EventBuffer) - sizeof(CompactEvents);
+}
+
+
+static inline uint64_t prismZigZag(int64_t val)
+{
+    return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+
+static inline int64_t prismUnZigZag(uint64_t val)
+{
+    return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+
+//-----------------------------------------------------------------------------
+/** Encoding **/
+
+struct PrismEncoder
+{
+    EventBuffer *buf;
+    uint8_t *pos;
+    uint8_t *end;
+    PtrVal lastMemAddr;
+    PtrVal lastInstrAddr;
+};
+
+
+static inline void prismEncoderInit(PrismEncoder *enc, EventBuffer *buf)
+{
+    /* Start encoding at the beginning of 'buf'.
+     * The buffer's encoding and capacity must already be set */
+
+    CompactEvents *compact = prismCompact(buf);
+    buf->used          = 0;
+    compact->bytes     = 0;
+    enc->buf           = buf;
+    enc->pos           = compact->data;
+    enc->end           = compact->data + prismCompactCapacity(buf);
+    enc->lastMemAddr   = 0;
+    enc->lastInstrAddr = 0;
+}
+
+
+static inline int prismEncoderFull(const PrismEncoder *enc)
+{
+    return (enc->end - enc->pos) < PRISM_COMPACT_MAX_EVENT_BYTES;
+}
+
+
+static inline void prismEncoderFinish(PrismEncoder *enc)
+{
+    /* Publish the stream length before handing the buffer to Prism */
+    prismCompact(enc->buf)->bytes = enc->pos - prismCompact(enc->buf)->data;
+}
+
+
+static inline void prismPutVarint(PrismEncoder *enc, uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        *enc->pos++ = (uint8_t)(val | 0x80);
+        val >>= 7;
+    }
+    *enc->pos++ = (uint8_t)val;
+}
+
+
+static inline uint8_t prismSizeCode(ByteCount size)
+{
+    /* log2 of power of 2 sizes up to 64 bytes, otherwise escape */
+    uint8_t code = 0;
+    while (code < 7 && ((ByteCount)1 << code) != size)
+        ++code;
+    return code;
+}
+
+
+static inline void prismEncodeMem(PrismEncoder *enc, MemType type, PtrVal addr, ByteCount size)
+{
+    uint8_t shortType = (type < 3) ? type : 3;
+    uint8_t sizeCode  = prismSizeCode(size);
+
+    *enc->pos++ = PRISM_MEM_TAG | (uint8_t)(shortType << 3) | (uint8_t)(sizeCode << 5);
+    if (shortType == 3)
+        prismPutVarint(enc, type);
+    if (sizeCode == 7)
+        prismPutVarint(enc, size);
+    prismPutVarint(enc, prismZigZag((int64_t)(addr - enc->lastMemAddr)));
+
+    enc->lastMemAddr = addr;
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeComp(PrismEncoder *enc, CompCostType type, CompArity arity,
+                                   CompCostOp op, uint8_t size)
+{
+    uint8_t shortType  = (type < 3) ? type : 3;
+    uint8_t shortArity = (arity < 7) ? arity : 7;
+
+    *enc->pos++ = PRISM_COMP_TAG | (uint8_t)(shortType << 3) | (uint8_t)(shortArity << 5);
+    if (shortType == 3)
+        prismPutVarint(enc, type);
+    if (shortArity == 7)
+        prismPutVarint(enc, arity);
+    prismPutVarint(enc, op | ((uint64_t)size << 8));
+
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeShortType(PrismEncoder *enc, EvTag tag, uint8_t type)
+{
+    /* tags whose only short field is a 5 bit type */
+    uint8_t shortType = (type < 31) ? type : 31;
+
+    *enc->pos++ = tag | (uint8_t)(shortType << 3);
+    if (shortType == 31)
+        prismPutVarint(enc, type);
+}
+
+
+static inline void prismEncodeCF(PrismEncoder *enc, CFType type)
+{
+    prismEncodeShortType(enc, PRISM_CF_TAG, type);
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeCxtName(PrismEncoder *enc, CxtType type, uint32_t idx, uint32_t len)
+{
+    /* PRISM_CXT_FUNC_* events refer to a name in the NameBuffer */
+    prismEncodeShortType(enc, PRISM_CXT_TAG, type);
+    prismPutVarint(enc, idx);
+    prismPutVarint(enc, len);
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeCxt(PrismEncoder *enc, CxtType type, PtrVal id)
+{
+    if (type == PRISM_CXT_FUNC_ENTER || type == PRISM_CXT_FUNC_EXIT)
+    {
+        /* 'id' aliases the name index and length, see PrismCxtEv */
+        prismEncodeCxtName(enc, type, (uint32_t)id, (uint32_t)(id >> 32));
+        return;
+    }
+
+    prismEncodeShortType(enc, PRISM_CXT_TAG, type);
+    if (type == PRISM_CXT_INSTR)
+    {
+        prismPutVarint(enc, prismZigZag((int64_t)(id - enc->lastInstrAddr)));
+        enc->lastInstrAddr = id;
+    }
+    else
+    {
+        prismPutVarint(enc, id);
+    }
+
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeSync(PrismEncoder *enc, SyncType type, SyncID data0, SyncID data1)
+{
+    prismEncodeShortType(enc, PRISM_SYNC_TAG, type);
+    prismPutVarint(enc, prismZigZag(data0));
+    prismPutVarint(enc, prismZigZag(data1));
+    ++enc->buf->used;
+}
+
+
+static inline void prismEncodeEvent(PrismEncoder *enc, const PrismEvVariant *ev)
+{
+    switch (ev->tag)
+    {
+    case PRISM_MEM_TAG:
+        prismEncodeMem(enc, ev->mem.type, ev->mem.begin_addr, ev->mem.size);
+        break;
+    case PRISM_COMP_TAG:
+        prismEncodeComp(enc, ev->comp.type, ev->comp.arity, ev->comp.op, ev->comp.size);
+        break;
+    case PRISM_CF_TAG:
+        prismEncodeCF(enc, ev->cf.type);
+        break;
+    case PRISM_CXT_TAG:
+        prismEncodeCxt(enc, ev->cxt.type, ev->cxt.id);
+        break;
+    case PRISM_SYNC_TAG:
+        prismEncodeSync(enc, ev->sync.type, ev->sync.data[0], ev->sync.data[1]);
+        break;
+    default:
+        break;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** Decoding **/
+
+static inline int prismGetVarint(const uint8_t **pos, const uint8_t *end, uint64_t *val)
+{
+    uint64_t result = 0;
+    unsigned shift = 0;
+    while (*pos < end && shift < 64)
+    {
+        uint8_t byte = *(*pos)++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *val = result;
+            return 1;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+
+static inline int prismDecodeCompact(const EventBuffer *src, EventBuffer *dst)
+{
+    /* Decode 'src' into packed events in 'dst', which must have room
+     * for src->used events. Returns 0 if the stream is malformed */
+
+    const CompactEvents *compact = prismCompact(src);
+    if (compact->bytes > prismCompactCapacity(src))
+        return 0;
+
+    const uint8_t *pos = compact->data;
+    const uint8_t *end = compact->data + compact->bytes;
+    PtrVal lastMemAddr = 0;
+    PtrVal lastInstrAddr = 0;
+    uint64_t val, val2;
+
+    dst->used     = 0;
+    dst->encoding = PRISM_EVENTS_PACKED;
+    dst->capacity = src->used;
+
+    for (size_t i = 0; i < src->used; ++i)
+    {
+        if (pos >= end)
+            return 0;
+
+        uint8_t head = *pos++;
+        uint8_t tag  = head & 0x7;
+        uint8_t info = head >> 3;
+        PrismEvVariant *ev = &dst->events[i];
+        ev->tag = tag;
+
+        switch (tag)
+        {
+        case PRISM_MEM_TAG:
+        {
+            uint8_t shortType = info & 0x3;
+            uint8_t sizeCode  = info >> 2;
+            ev->mem.type = shortType;
+            ev->mem.size = (ByteCount)1 << sizeCode;
+            if (shortType == 3)
+            {
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+                ev->mem.type = (MemType)val;
+            }
+            if (sizeCode == 7)
+            {
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+                ev->mem.size = (ByteCount)val;
+            }
+            if (!prismGetVarint(&pos, end, &val))
+                return 0;
+            lastMemAddr += (PtrVal)prismUnZigZag(val);
+            ev->mem.begin_addr = lastMemAddr;
+            break;
+        }
+        case PRISM_COMP_TAG:
+        {
+            uint8_t shortType  = info & 0x3;
+            uint8_t shortArity = info >> 2;
+            ev->comp.type  = shortType;
+            ev->comp.arity = shortArity;
+            if (shortType == 3)
+            {
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+                ev->comp.type = (CompCostType)val;
+            }
+            if (shortArity == 7)
+            {
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+                ev->comp.arity = (CompArity)val;
+            }
+            if (!prismGetVarint(&pos, end, &val))
+                return 0;
+            ev->comp.op   = (CompCostOp)(val & 0xff);
+            ev->comp.size = (uint8_t)(val >> 8);
+            break;
+        }
+        case PRISM_CF_TAG:
+        case PRISM_CXT_TAG:
+        case PRISM_SYNC_TAG:
+        {
+            uint8_t type = info;
+            if (info == 31)
+            {
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+                type = (uint8_t)val;
+            }
+
+            if (tag == PRISM_CF_TAG)
+            {
+                ev->cf.type = type;
+            }
+            else if (tag == PRISM_CXT_TAG)
+            {
+                ev->cxt.type = type;
+                if (!prismGetVarint(&pos, end, &val))
+                    return 0;
+
+                if (type == PRISM_CXT_INSTR)
+                {
+                    lastInstrAddr += (PtrVal)prismUnZigZag(val);
+                    ev->cxt.id = lastInstrAddr;
+                }
+                else if (type == PRISM_CXT_FUNC_ENTER || type == PRISM_CXT_FUNC_EXIT)
+                {
+                    if (!prismGetVarint(&pos, end, &val2))
+                        return 0;
+                    ev->cxt.idx = (uint32_t)val;
+                    ev->cxt.len = (uint32_t)val2;
+                }
+                else
+                {
+                    ev->cxt.id = (PtrVal)val;
+                }
+            }
+            else
+            {
+                ev->sync.type = type;
+                if (!prismGetVarint(&pos, end, &val) ||
+                    !prismGetVarint(&pos, end, &val2))
+                    return 0;
+                ev->sync.data[0] = (SyncID)prismUnZigZag(val);
+                ev->sync.data[1] = (SyncID)prismUnZigZag(val2);
+            }
+            break;
+        }
+        default:
+            return 0;
+        }
+
+        dst->used = i + 1;
+    }
+
+    return pos == end;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif
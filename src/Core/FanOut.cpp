@@ -0,0 +1,80 @@
+#include "FanOut.hpp"
+#include <cassert>
+
+namespace prism
+{
+
+FanOutBackend::FanOutBackend(std::vector<BackendPtr> backends, bool threaded)
+    : backends(std::move(backends))
+{
+    assert(this->backends.empty() == false);
+
+    if (threaded == true)
+        for (unsigned i = 1; i < this->backends.size(); ++i)
+            workers.emplace_back(&FanOutBackend::worker, this, i);
+}
+
+
+FanOutBackend::~FanOutBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    started.notify_all();
+
+    for (auto &w : workers)
+        w.join();
+}
+
+
+auto FanOutBackend::onEvents(const EventBuffer &buf, const GetNameBase &nameBase) -> void
+{
+    if (workers.empty() == true)
+    {
+        for (auto &be : backends)
+            be->onEvents(buf, nameBase);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        current = &buf;
+        currentNames = &nameBase;
+        pending = workers.size();
+        ++generation;
+    }
+    started.notify_all();
+
+    backends[0]->onEvents(buf, nameBase);
+
+    /* the buffer goes back to the frontend when this returns */
+    std::unique_lock<std::mutex> lock(mtx);
+    finished.wait(lock, [&]{ return pending == 0; });
+}
+
+
+auto FanOutBackend::worker(unsigned idx) -> void
+{
+    unsigned long seen = 0;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        started.wait(lock, [&]{ return generation != seen || stop; });
+        if (generation == seen)
+            return;
+        seen = generation;
+
+        auto buf = current;
+        auto nameBase = currentNames;
+        lock.unlock();
+        backends[idx]->onEvents(*buf, *nameBase);
+        lock.lock();
+
+        if (--pending == 0)
+            finished.notify_one();
+    }
+}
+
+}; //end namespace prism
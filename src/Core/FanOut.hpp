@@ -0,0 +1,53 @@
+#ifndef PRISM_FANOUT_H
+#define PRISM_FANOUT_H
+
+#include "Backends.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace prism
+{
+
+class FanOutBackend : public BackendIface
+{
+    /* Hands every event buffer to several backends, so one
+     * instrumentation pass feeds all of them.
+     *
+     * Sequential mode calls each backend in turn.
+     * Threaded mode runs backends 1..n-1 on their own threads while the
+     * calling thread runs backend 0; all of them read the same buffer.
+     * onEvents returns only once every backend is done with the buffer,
+     * so the frontend still gets its buffers back in acquisition order.
+     * The buffer's name arena (nameBase) is shared read-only as well.
+     *
+     * Each backend only ever sees its own instance being called from
+     * one thread at a time, as without fan-out. */
+
+  public:
+    FanOutBackend(std::vector<BackendPtr> backends, bool threaded);
+    ~FanOutBackend() override;
+
+    virtual auto onEvents(const EventBuffer &buf,
+                          const GetNameBase &nameBase) -> void override final;
+
+  private:
+    auto worker(unsigned idx) -> void;
+
+    std::vector<BackendPtr> backends;
+    std::vector<std::thread> workers;
+
+    std::mutex mtx;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const EventBuffer *current{nullptr};
+    const GetNameBase *currentNames{nullptr};
+    unsigned long generation{0};
+    unsigned pending{0};
+    /* number of workers still reading the current buffer */
+    bool stop{false};
+};
+
+}; //end namespace prism
+
+#endif
@@ -5,7 +5,8 @@
 decltype(FrontendIface::uidCount) FrontendIface::uidCount{0};
 
 auto FrontendFactory::create(ToolName name, Args exec, Args fe, unsigned threads,
-                             const prism::capabilities &beReqs) const -> FrontendStarterWrapper
+                             const prism::capabilities &beReqs,
+                             const IpcConfig &ipc) const -> FrontendStarterWrapper
 {
     using namespace std::placeholders;
 
@@ -23,7 +24,7 @@ auto FrontendFactory::create(ToolName name, Args exec, Args fe, unsigned threads
         /* Resolve difference between requested capabilities (granularity)
          * from the backend, and the available capabilities in the frontend */
         auto caps = prism::resolveCaps(feCaps, beReqs);;
-        return [=]{ return start(exec, fe, threads, caps); };
+        return [=]{ return start(exec, fe, threads, caps, ipc); };
     }
     else
     {
@@ -2,6 +2,7 @@
 #define PRISM_FRONTEND_H
 
 #include "EventBuffer.h"
+#include "Frontends/CommonShmemIPC.h"
 #include <map>
 #include <functional>
 #include <string>
@@ -14,6 +15,7 @@ using ToolName = std::string;
 using Args = std::vector<std::string>;
 
 using GetNameBase = std::function<const char*(void)>;
+using GetTimestamps = std::function<const TimestampBuffer*(void)>;
 class FrontendIface
 {
     /* The Prism core asynchronously requests an event buffer
@@ -35,6 +37,11 @@ class FrontendIface
      * it must implement this function to return the memory arena where
      * name strings are stored. XXX MDL20170412 See DbiFrontend.hpp */
 
+    GetTimestamps timestamps;
+    /* If a frontend timestamps its events, it implements this function
+     * to return the timestamps of the last acquired buffer,
+     * one per event in stream order. See MergedFrontend */
+
   protected:
     const unsigned uid;
   private:
@@ -42,10 +49,49 @@ class FrontendIface
 };
 
 
+enum class IpcTransport
+{
+    fifo,
+    futex,
+};
+
+enum class EventEncoding
+{
+    packed,
+    columns,
+    compact,
+};
+
+struct IpcConfig
+{
+    /* Settings for frontends that talk to Prism
+     * through shared memory (see CommonShmemIPC.h).
+     * Chosen on the Prism command line and handed to the
+     * external tool through the shared memory header. */
+
+    IpcTransport transport{IpcTransport::fifo};
+    EventEncoding encoding{EventEncoding::packed};
+    unsigned buffers{PRISM_IPC_BUFFERS};
+    unsigned bufferEvents{PRISM_EVENTS_BUFFER_SIZE};
+    bool hugePages{false};
+    /* Only affects how Prism maps the segment,
+     * so it is not visible to the external tool */
+
+    auto isDefault() const -> bool
+    {
+        return transport == IpcTransport::fifo &&
+               encoding == EventEncoding::packed &&
+               buffers == PRISM_IPC_BUFFERS &&
+               bufferEvents == PRISM_EVENTS_BUFFER_SIZE;
+    }
+};
+
+
 using FrontendPtr = std::unique_ptr<FrontendIface>;
 using FrontendIfaceGenerator = std::function<FrontendPtr(void)>;
 using FrontendStarter = std::function<FrontendIfaceGenerator(Args, Args, unsigned,
-                                                             const prism::capabilities&)>;
+                                                             const prism::capabilities&,
+                                                             const IpcConfig&)>;
 using FrontendStarterWrapper = std::function<FrontendIfaceGenerator()>;
 /* The actual frontend must provide a 'starter' function that returns
  * a function to generate interfaces to the frontend as defined above.
@@ -57,7 +103,8 @@ using FrontendStarterWrapper = std::function<FrontendIfaceGenerator()>;
  * - the executable and its args
  * - args specifically for the frontend
  * - number of threads in the system
- * - requested capabilities from backend */
+ * - requested capabilities from backend
+ * - shared memory IPC settings */
 
 
 struct Frontend
@@ -74,7 +121,8 @@ class FrontendFactory
     ~FrontendFactory() = default;
 
     auto create(ToolName name, Args exec, Args fe, unsigned threads,
-                const prism::capabilities &beReqs) const -> FrontendStarterWrapper;
+                const prism::capabilities &beReqs,
+                const IpcConfig &ipc) const -> FrontendStarterWrapper;
     auto add(ToolName name, Frontend fe) -> void;
     auto exists(ToolName name) const -> bool;
     auto available() const -> std::vector<std::string>;
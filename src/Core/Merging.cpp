@@ -0,0 +1,233 @@
+#include "Merging.hpp"
+#include "PrismLog.hpp"
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+namespace prism
+{
+
+namespace
+{
+
+auto isNamed(const PrismEvVariant &ev) -> bool
+{
+    return ev.tag == EvTagEnum::PRISM_CXT_TAG &&
+           (ev.cxt.type == CxtTypeEnum::PRISM_CXT_FUNC_ENTER ||
+            ev.cxt.type == CxtTypeEnum::PRISM_CXT_FUNC_EXIT);
+}
+
+
+auto isSwap(const PrismEvVariant &ev) -> bool
+{
+    return ev.tag == EvTagEnum::PRISM_SYNC_TAG &&
+           ev.sync.type == SyncTypeEnum::PRISM_SYNC_SWAP;
+}
+
+}; //end namespace
+
+
+MergedFrontend::MergedFrontend(std::vector<FrontendPtr> frontends, unsigned capacity)
+    : inputs(frontends.size())
+    , capacity(capacity)
+    , storage(prismEventBufferSize(PRISM_EVENTS_PACKED, capacity))
+    , names(PRISM_NAMES_BUFFER_SIZE)
+{
+    assert(frontends.empty() == false);
+    assert(capacity >= 2);
+
+    for (unsigned i = 0; i < frontends.size(); ++i)
+    {
+        if (!frontends[i]->timestamps)
+            PrismLog::fatal("merging event streams requires a frontend with timestamps, "
+                            "i.e. 'perf'");
+        inputs[i].frontend = std::move(frontends[i]);
+        inputs[i].thread = i + 1;
+    }
+
+    merged()->used     = 0;
+    merged()->encoding = PRISM_EVENTS_PACKED;
+    merged()->capacity = capacity;
+
+    FrontendIface::nameBase = [&]{ return names.data(); };
+}
+
+
+MergedFrontend::~MergedFrontend()
+{
+    for (auto &in : inputs)
+        if (in.buf != nullptr)
+            in.frontend->releaseBuffer(std::move(in.buf));
+
+    PrismLog::info("merge      : {} events from {} streams, {} swaps inserted",
+                   mergedEvents, inputs.size(), insertedSwaps);
+    PrismLog::info("merge      : {} buffers handed off early to wait for a stream",
+                   earlyFlushes);
+}
+
+
+auto MergedFrontend::refill(unsigned idx) -> void
+{
+    /* Replace an exhausted input buffer with the next non-empty one,
+     * and put the input back into the heap unless it has finished */
+    Input &in = inputs[idx];
+
+    if (in.buf != nullptr)
+        in.frontend->releaseBuffer(std::move(in.buf));
+
+    in.buf = in.frontend->acquireBuffer();
+    while (in.buf != nullptr && in.buf->used == 0)
+    {
+        in.frontend->releaseBuffer(std::move(in.buf));
+        in.buf = in.frontend->acquireBuffer();
+    }
+
+    if (in.buf == nullptr)
+        return;
+
+    const TimestampBuffer *times = in.frontend->timestamps();
+    if (times == nullptr || times->used != in.buf->used)
+        PrismLog::fatal("merging event streams: timestamps do not match events");
+
+    in.events = in.buf.get();
+    if (in.buf->encoding == PRISM_EVENTS_COLUMNS)
+    {
+        /* the merge walks events in stream order */
+        in.unpacked.resize(prismEventBufferSize(PRISM_EVENTS_PACKED, in.buf->used));
+        auto packed = reinterpret_cast<EventBuffer*>(in.unpacked.data());
+        prismColumnsUnpack(packed, in.buf.get());
+        in.events = packed;
+    }
+    in.timestamps = times->timestamps;
+    in.next = 0;
+
+    heap.push({in.timestamps[0], idx});
+}
+
+
+auto MergedFrontend::fits(const PrismEvVariant &ev) -> bool
+{
+    /* leave room for a synthetic swap before the next event */
+    if (merged()->used + 2 > capacity)
+        return false;
+    if (isNamed(ev) && namesUsed + ev.cxt.len > names.size())
+        return false;
+    return true;
+}
+
+
+auto MergedFrontend::swapTo(SyncID thread) -> void
+{
+    PrismEvVariant &ev = merged()->events[merged()->used++];
+    ev.tag = EvTagEnum::PRISM_SYNC_TAG;
+    ev.sync.type = SyncTypeEnum::PRISM_SYNC_SWAP;
+    ev.sync.data[0] = thread;
+    ev.sync.data[1] = 0;
+    currentThread = thread;
+    ++insertedSwaps;
+}
+
+
+auto MergedFrontend::emit(const PrismEvVariant &ev, const Input &in) -> void
+{
+    PrismEvVariant &out = merged()->events[merged()->used++];
+    out = ev;
+
+    if (isNamed(ev))
+    {
+        /* names refer to the input's arena, move them to ours */
+        std::memcpy(names.data() + namesUsed, in.frontend->nameBase() + ev.cxt.idx, ev.cxt.len);
+        out.cxt.idx = namesUsed;
+        namesUsed += ev.cxt.len;
+    }
+
+    ++mergedEvents;
+}
+
+
+auto MergedFrontend::acquireBuffer() -> EventBufferPtr
+{
+    if (started == false)
+    {
+        for (unsigned i = 0; i < inputs.size(); ++i)
+            refill(i);
+        started = true;
+    }
+    else if (pendingRefill >= 0)
+    {
+        refill(pendingRefill);
+        pendingRefill = -1;
+    }
+
+    bool full = false;
+    while (heap.empty() == false && full == false)
+    {
+        auto top = heap.top();
+        heap.pop();
+        Input &in = inputs[top.second];
+
+        /* take events from this input until another input is due */
+        const HeapEntry limit = heap.empty() ?
+                                HeapEntry{UINT64_MAX, UINT_MAX} :
+                                heap.top();
+
+        while (in.next < in.events->used)
+        {
+            const PrismEvVariant &ev = in.events->events[in.next];
+            if (HeapEntry{in.timestamps[in.next], top.second} > limit)
+                break;
+            if (fits(ev) == false)
+            {
+                full = true;
+                break;
+            }
+
+            if (isSwap(ev))
+            {
+                in.thread = ev.sync.data[0];
+                currentThread = in.thread;
+            }
+            else if (in.thread != currentThread)
+            {
+                swapTo(in.thread);
+            }
+
+            emit(ev, in);
+            ++in.next;
+        }
+
+        if (in.next < in.events->used)
+        {
+            heap.push({in.timestamps[in.next], top.second});
+        }
+        else if (merged()->used > 0)
+        {
+            /* refilling may block, so hand off what is merged first */
+            pendingRefill = top.second;
+            ++earlyFlushes;
+            break;
+        }
+        else
+        {
+            refill(top.second);
+        }
+    }
+
+    if (merged()->used == 0)
+        return nullptr;
+    else
+        return EventBufferPtr(merged());
+}
+
+
+auto MergedFrontend::releaseBuffer(EventBufferPtr buf) -> void
+{
+    assert(buf.get() == merged());
+    buf.release();
+
+    merged()->used = 0;
+    namesUsed = 0;
+}
+
+}; //end namespace prism
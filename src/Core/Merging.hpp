@@ -0,0 +1,82 @@
+#ifndef PRISM_MERGING_H
+#define PRISM_MERGING_H
+
+#include "Frontends.hpp"
+#include <queue>
+
+namespace prism
+{
+
+class MergedFrontend : public FrontendIface
+{
+    /* Merges several timestamped frontend streams into one
+     * globally ordered stream for a single backend.
+     *
+     * Each input frontend must provide timestamps (FrontendIface::timestamps)
+     * that never decrease within its own stream. A min-heap keyed on
+     * each input's next timestamp picks the input to take events from;
+     * events with equal timestamps are taken from the lower input first.
+     * Whenever the merged stream moves to a different input, a synthetic
+     * PRISM_SYNC_SWAP to that input's thread is inserted. An input's thread
+     * is its index + 1 until the input sends its own PRISM_SYNC_SWAP.
+     *
+     * Buffering is bounded: at most one acquired buffer per input, plus one
+     * merged buffer. The next timestamp of an input is unknown until its next
+     * buffer arrives, so the merge must wait on an input that runs dry.
+     * Before it waits, the events merged so far are handed to the backend,
+     * so merge latency is at most one input buffer.
+     *
+     * The merged buffers are always in the packed encoding. Context names
+     * are copied into the merged buffer's own name arena. */
+
+    struct Input
+    {
+        FrontendPtr frontend;
+        EventBufferPtr buf;
+        const EventBuffer *events{nullptr};
+        const uint64_t *timestamps{nullptr};
+        std::vector<char> unpacked;
+        /* a packed copy of 'buf' if it is in the column encoding */
+        size_t next{0};
+        SyncID thread;
+    };
+
+    using HeapEntry = std::pair<uint64_t, unsigned>;
+    /* next timestamp of an input, and its index */
+
+  public:
+    MergedFrontend(std::vector<FrontendPtr> inputs,
+                   unsigned capacity = PRISM_EVENTS_BUFFER_SIZE);
+    ~MergedFrontend() override;
+
+    virtual auto acquireBuffer() -> EventBufferPtr override final;
+    virtual auto releaseBuffer(EventBufferPtr) -> void override final;
+
+  private:
+    auto refill(unsigned idx) -> void;
+    auto fits(const PrismEvVariant &ev) -> bool;
+    auto emit(const PrismEvVariant &ev, const Input &in) -> void;
+    auto swapTo(SyncID thread) -> void;
+    auto merged() -> EventBuffer* { return reinterpret_cast<EventBuffer*>(storage.data()); }
+
+    std::vector<Input> inputs;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+    int pendingRefill{-1};
+    bool started{false};
+
+    const unsigned capacity;
+    std::vector<char> storage;
+    std::vector<char> names;
+    size_t namesUsed{0};
+    SyncID currentThread{0};
+    /* merged output */
+
+    unsigned long mergedEvents{0};
+    unsigned long insertedSwaps{0};
+    unsigned long earlyFlushes{0};
+    /* statistics */
+};
+
+}; //end namespace prism
+
+#endif
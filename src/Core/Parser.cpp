@@ -15,11 +15,21 @@ constexpr char Parser::backendOption[];
 constexpr char Parser::executableOption[];
 constexpr char Parser::numThreadsOption[];
 constexpr char Parser::timeOption[];
+constexpr char Parser::stagingOption[];
+constexpr char Parser::mergeOption[];
+constexpr char Parser::fanoutOption[];
+constexpr char Parser::statsOption[];
+constexpr char Parser::statsFileOption[];
+constexpr char Parser::transportOption[];
+constexpr char Parser::encodingOption[];
+constexpr char Parser::ipcBuffersOption[];
+constexpr char Parser::ipcEventsOption[];
+constexpr char Parser::hugePagesOption[];
 
 Parser::Parser(int argc, char* argv[])
 {
     parser.addGroup(frontendOption, false);
-    parser.addGroup(backendOption, true);
+    parser.addGroup(backendOption, true, true);
     parser.addGroup(executableOption, true);
     parser.parse(argc, argv);
 }
@@ -28,8 +38,8 @@ Parser::Parser(int argc, char* argv[])
 auto Parser::threads() const -> int
 {
     /* The number of 'threads' Prism will use */
-    /* MDL20160805 Currently only valid with DynamoRIO frontend.
-     * This will cause 'n' event streams between Prism and DynamoRIO
+    /* MDL20160805 Currently only valid with DynamoRIO and Valgrind frontends.
+     * This will cause 'n' event streams between Prism and the frontend
      * to be generated, and 'n' separate backend instances will
      * read from those event streams as separate threads */
 
@@ -39,7 +49,7 @@ auto Parser::threads() const -> int
     {
         threads = stoi(threadsArg);
 
-        if (threads > 16 || threads < 1)
+        if (threads > PRISM_IPC_MAX_CHANNELS || threads < 1)
             fatal("Invalid number of threads specified");
     }
 
@@ -47,9 +57,20 @@ auto Parser::threads() const -> int
 }
 
 
-auto Parser::backend() const -> ToolTuple
+auto Parser::backends() const -> std::vector<ToolTuple>
 {
-    return tool(backendOption);
+    /* Every backend consumes the same event stream,
+     * e.g. --backend=stgen -o out --backend=simplecount */
+
+    std::vector<ToolTuple> tools;
+    for (const auto &args : parser.getGroups(backendOption))
+    {
+        auto name = args.front();
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        tools.emplace_back(name, Args{args.cbegin() + 1, args.cend()});
+    }
+
+    return tools;
 }
 
 
@@ -93,6 +114,209 @@ auto Parser::timed() const -> bool
 }
 
 
+auto Parser::stagingBuffers() const -> unsigned
+{
+    /* The number of Prism-owned buffers staged between the
+     * frontend and each backend thread.
+     * Zero disables staging; the backend reads frontend buffers directly */
+
+    int buffers = 0;
+    const auto stagingArg = parser.getOpt(stagingOption);
+    if (stagingArg.empty() == false)
+    {
+        buffers = stoi(stagingArg);
+
+        if (buffers > 1024 || buffers < 0)
+            fatal("Invalid number of staging buffers specified");
+    }
+
+    return buffers;
+}
+
+
+auto Parser::mergeStreams() const -> bool
+{
+    /* Merge all frontend streams by timestamp into one backend thread,
+     * instead of one backend thread per stream */
+
+    auto mergeArg = parser.getOpt(mergeOption);
+    if (mergeArg.empty() == false)
+    {
+        std::transform(mergeArg.begin(), mergeArg.end(), mergeArg.begin(), ::tolower);
+        if (mergeArg == "on")
+            return true;
+        else if (mergeArg == "off")
+            return false;
+        else
+            fatal("Invalid 'merge-streams' option specified: " + mergeArg);
+    }
+
+    return false;
+}
+
+
+auto Parser::fanoutThreads() const -> bool
+{
+    /* With several backends, run each on its own thread
+     * instead of one after the other */
+
+    auto fanoutArg = parser.getOpt(fanoutOption);
+    if (fanoutArg.empty() == false)
+    {
+        std::transform(fanoutArg.begin(), fanoutArg.end(), fanoutArg.begin(), ::tolower);
+        if (fanoutArg == "on")
+            return true;
+        else if (fanoutArg == "off")
+            return false;
+        else
+            fatal("Invalid 'fanout-threads' option specified: " + fanoutArg);
+    }
+
+    return false;
+}
+
+
+auto Parser::stats() const -> StatsConfig
+{
+    /* Pipeline statistics:
+     * 'on' summarizes them at exit, a number of seconds
+     * also reports them periodically */
+
+    StatsConfig stats;
+    auto statsArg = parser.getOpt(statsOption);
+    if (statsArg.empty() == false)
+    {
+        std::transform(statsArg.begin(), statsArg.end(), statsArg.begin(), ::tolower);
+        if (statsArg == "on")
+            stats.enabled = true;
+        else if (statsArg != "off")
+        {
+            try
+            {
+                size_t end;
+                auto interval = std::stoi(statsArg, &end);
+                if (end != statsArg.size() || interval < 1)
+                    throw std::invalid_argument(statsArg);
+                stats.enabled = true;
+                stats.interval = interval;
+            }
+            catch (std::exception &e)
+            {
+                fatal("Invalid 'stats' option specified: " + statsArg);
+            }
+        }
+    }
+
+    stats.path = parser.getOpt(statsFileOption);
+    if (stats.path.empty() == false && stats.enabled == false)
+        warn("'stats-file' given without 'stats', no statistics will be written");
+
+    return stats;
+}
+
+
+auto Parser::ipcTransport() const -> IpcTransport
+{
+    /* How shared memory frontends signal full and empty buffers */
+
+    auto transportArg = parser.getOpt(transportOption);
+    if (transportArg.empty() == false)
+    {
+        std::transform(transportArg.begin(), transportArg.end(), transportArg.begin(), ::tolower);
+        if (transportArg == "fifo")
+            return IpcTransport::fifo;
+        else if (transportArg == "futex")
+            return IpcTransport::futex;
+        else
+            fatal("Invalid 'ipc-transport' option specified: " + transportArg);
+    }
+
+    return IpcTransport::fifo;
+}
+
+
+auto Parser::ipcEncoding() const -> EventEncoding
+{
+    /* How shared memory frontends lay out events in a buffer */
+
+    auto encodingArg = parser.getOpt(encodingOption);
+    if (encodingArg.empty() == false)
+    {
+        std::transform(encodingArg.begin(), encodingArg.end(), encodingArg.begin(), ::tolower);
+        if (encodingArg == "packed")
+            return EventEncoding::packed;
+        else if (encodingArg == "columns")
+            return EventEncoding::columns;
+        else if (encodingArg == "compact")
+            return EventEncoding::compact;
+        else
+            fatal("Invalid 'ipc-encoding' option specified: " + encodingArg);
+    }
+
+    return EventEncoding::packed;
+}
+
+
+auto Parser::ipcBuffers() const -> unsigned
+{
+    /* Number of shared memory buffers between Prism and the external tool */
+
+    int buffers = PRISM_IPC_BUFFERS;
+    const auto buffersArg = parser.getOpt(ipcBuffersOption);
+    if (buffersArg.empty() == false)
+    {
+        buffers = stoi(buffersArg);
+
+        if (buffers < 2 || buffers > PRISM_IPC_MAX_BUFFERS || (buffers & (buffers - 1)) != 0)
+            fatal("Invalid number of IPC buffers specified, "
+                  "must be a power of 2 between 2 and {}", PRISM_IPC_MAX_BUFFERS);
+    }
+
+    return buffers;
+}
+
+
+auto Parser::ipcBufferEvents() const -> unsigned
+{
+    /* Number of events each shared memory buffer holds */
+
+    long events = PRISM_EVENTS_BUFFER_SIZE;
+    const auto eventsArg = parser.getOpt(ipcEventsOption);
+    if (eventsArg.empty() == false)
+    {
+        events = stol(eventsArg);
+
+        if (events < long{PRISM_IPC_MIN_BUFFER_EVENTS} ||
+            events > long{PRISM_IPC_MAX_BUFFER_EVENTS})
+            fatal("Invalid number of events per IPC buffer specified, "
+                  "must be between {} and {}",
+                  PRISM_IPC_MIN_BUFFER_EVENTS, PRISM_IPC_MAX_BUFFER_EVENTS);
+    }
+
+    return events;
+}
+
+
+auto Parser::ipcHugePages() const -> bool
+{
+    /* Back the shared memory buffers with transparent huge pages */
+
+    auto hugePagesArg = parser.getOpt(hugePagesOption);
+    if (hugePagesArg.empty() == false)
+    {
+        std::transform(hugePagesArg.begin(), hugePagesArg.end(), hugePagesArg.begin(), ::tolower);
+        if (hugePagesArg == "on")
+            return true;
+        else if (hugePagesArg == "off")
+            return false;
+        else
+            fatal("Invalid 'ipc-hugepages' option specified: " + hugePagesArg);
+    }
+
+    return false;
+}
+
+
 auto Parser::tool(const char* option) const -> ToolTuple
 {
     const auto args = parser.getGroup(option);
@@ -123,20 +347,29 @@ auto ArgGroup::display_help() -> void
         help += "[--" + option + "=VALUE" + " [options]] ";
 
     for (const auto &option : required_groups)
+    {
         help += "--" + option + "=VALUE" + " [options] ";
+        if (std::find(repeatable_groups.cbegin(), repeatable_groups.cend(), option) != repeatable_groups.cend())
+            help += "[--" + option + "=VALUE" + " [options]]... ";
+    }
 
     warn(help);
 }
 
 
-auto ArgGroup::addGroup(const std::string &group, bool required) -> void
+auto ArgGroup::addGroup(const std::string &group, bool required, bool repeatable) -> void
 {
     if (group.empty() == true)
     {
         return;
     }
 
-    group_args.emplace(group, Args());
+    group_args.emplace(group, std::vector<Args>());
+
+    if (repeatable)
+    {
+        repeatable_groups.emplace_back(group);
+    }
 
     if (required)
     {
@@ -173,15 +406,16 @@ auto ArgGroup::tryGroup(const std::string &arg) -> bool
         return false;
     }
 
-    /* duplicate option groups not allowed */
+    /* duplicate option groups not allowed, unless repeatable */
     prev_group = rem.substr(0, eqidx);
-    if (group_args.at(prev_group).empty() == false)
+    if (group_args.at(prev_group).empty() == false &&
+        std::find(repeatable_groups.cbegin(), repeatable_groups.cend(), prev_group) == repeatable_groups.cend())
     {
         fatal(arg + " is duplicate option");
     }
 
     /* initialize the group of args with this first argument */
-    group_args.at(prev_group).push_back(rem.substr(eqidx + 1));
+    group_args.at(prev_group).push_back({rem.substr(eqidx + 1)});
 
     return true;
 }
@@ -196,7 +430,7 @@ auto ArgGroup::addArg(const std::string &arg) -> void
 
     if (prev_group.empty() == false)
     {
-        group_args.at(prev_group).push_back(arg);
+        group_args.at(prev_group).back().push_back(arg);
     }
     else
     {
@@ -226,11 +460,24 @@ auto ArgGroup::getGroup(const std::string &group) const -> Args
 {
     auto group_search = group_args.find(group);
 
-    if (group_search == group_args.cend())
+    if (group_search == group_args.cend() || group_search->second.empty())
     {
         return std::vector<std::string>();
     }
 
+    return group_search->second.front();
+}
+
+
+auto ArgGroup::getGroups(const std::string &group) const -> std::vector<Args>
+{
+    auto group_search = group_args.find(group);
+
+    if (group_search == group_args.cend())
+    {
+        return std::vector<Args>();
+    }
+
     return group_search->second;
 }
 
@@ -5,6 +5,7 @@
 #include "PrismLog.hpp"
 #include "Backends.hpp"
 #include "Frontends.hpp"
+#include "Stats.hpp"
 
 namespace prism
 {
@@ -26,8 +27,9 @@ class ArgGroup
 
     using Args = std::vector<std::string>;
   public:
-    auto addGroup(const std::string &group, bool required) -> void;
-    /* Add a long option to group args */
+    auto addGroup(const std::string &group, bool required, bool repeatable = false) -> void;
+    /* Add a long option to group args.
+     * A repeatable group may be given more than once */
 
     auto tryGroup(const std::string& arg) -> bool;
     auto addArg(const std::string& arg) -> void;
@@ -37,14 +39,16 @@ class ArgGroup
      * long_opt is to be in the form: "--long_opt=argument" */
 
     auto getGroup(const std::string& group) const -> Args;
+    auto getGroups(const std::string& group) const -> std::vector<Args>;
+    /* the first, or every, occurrence of a group */
     auto getOpt(const std::string& opt) const -> std::string;
 
     auto parse(int argc, char* argv[]) -> bool;
     auto display_help() -> void;
 
   private:
-    std::map<std::string, Args> group_args;
-    /* long opt -> args */
+    std::map<std::string, std::vector<Args>> group_args;
+    /* long opt -> args of each occurrence */
 
     std::map<std::string, std::string> args;
     /* command line args that don't follow a group */
@@ -52,6 +56,7 @@ class ArgGroup
     const Args empty_group;
     Args required_groups;
     Args optional_groups;
+    Args repeatable_groups;
     std::string prev_group;
 };
 
@@ -63,10 +68,19 @@ class Parser
     Parser(int argc, char* argv[]);
 
     auto threads()    const -> int;
-    auto backend()    const -> ToolTuple;
+    auto backends()   const -> std::vector<ToolTuple>;
     auto frontend()   const -> ToolTuple;
     auto executable() const -> Args;
     auto timed()      const -> bool;
+    auto stagingBuffers() const -> unsigned;
+    auto mergeStreams() const -> bool;
+    auto fanoutThreads() const -> bool;
+    auto stats() const -> StatsConfig;
+    auto ipcTransport() const -> IpcTransport;
+    auto ipcEncoding() const -> EventEncoding;
+    auto ipcBuffers() const -> unsigned;
+    auto ipcBufferEvents() const -> unsigned;
+    auto ipcHugePages() const -> bool;
 
     auto tool(const char* option) const -> ToolTuple;
     /* get tool options in the form of a name and consecutive options:
@@ -79,6 +93,16 @@ class Parser
     static constexpr char executableOption[] = "executable";
     static constexpr char numThreadsOption[] = "num-threads";
     static constexpr char timeOption[]       = "sgl-time";
+    static constexpr char stagingOption[]    = "staging-buffers";
+    static constexpr char mergeOption[]      = "merge-streams";
+    static constexpr char fanoutOption[]     = "fanout-threads";
+    static constexpr char statsOption[]      = "stats";
+    static constexpr char statsFileOption[]  = "stats-file";
+    static constexpr char transportOption[]  = "ipc-transport";
+    static constexpr char encodingOption[]   = "ipc-encoding";
+    static constexpr char ipcBuffersOption[] = "ipc-buffers";
+    static constexpr char ipcEventsOption[]  = "ipc-buffer-events";
+    static constexpr char hugePagesOption[]  = "ipc-hugepages";
 };
 
 }; //end namespace prism
@@ -40,6 +40,7 @@
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <stdexcept>
 extern "C" {
 #else
 typedef struct PrismMemEv PrismMemEv;
@@ -71,9 +72,22 @@ struct PrismMemEv
 struct PrismCompEv
 {
     CompCostType type;
-    CompArity    arity;
-    CompCostOp   op;
-    uint8_t      size;
+    union
+    {
+        struct
+        {
+            CompArity  arity;
+            CompCostOp op;
+            uint8_t    size;
+        };
+        struct
+        {
+            uint8_t iops;
+            uint8_t flops;
+            uint8_t otherOps;
+        };
+        /* PRISM_COMP_BATCH: ops since the previous event, up to 255 each */
+    };
 } __attribute__ ((__packed__));
 
 struct PrismCFEv
@@ -105,6 +119,30 @@ struct PrismSyncEv
 
 } __attribute__ ((__packed__));
 
+
+/* A PRISM_CXT_BB event marks one executed basic block, and packs its
+ * static counts into the 'id' of the context event:
+ *
+ *   bits  0..31  block id
+ *   bits 32..39  guest instructions
+ *   bits 40..51  integer ops
+ *   bits 52..63  floating point ops
+ *
+ * Counts saturate at the field width */
+#define PRISM_BB_MAX_INSTRS 0xff
+#define PRISM_BB_MAX_OPS    0xfff
+
+static inline PtrVal prismPackBB(uint32_t bb, uint32_t instrs, uint32_t iops, uint32_t flops)
+{
+    instrs = instrs < PRISM_BB_MAX_INSTRS ? instrs : PRISM_BB_MAX_INSTRS;
+    iops   = iops   < PRISM_BB_MAX_OPS    ? iops   : PRISM_BB_MAX_OPS;
+    flops  = flops  < PRISM_BB_MAX_OPS    ? flops  : PRISM_BB_MAX_OPS;
+    return (PtrVal)bb |
+           (PtrVal)instrs << 32 |
+           (PtrVal)iops   << 40 |
+           (PtrVal)flops  << 52;
+}
+
 #ifdef __cplusplus
 } // end extern "C"
 
@@ -132,6 +170,11 @@ struct CompEvent
     auto type() const -> CompCostType { return ev.type; }
     auto isIOP() const -> bool { return (ev.type == CompCostTypeEnum::PRISM_COMP_IOP); }
     auto isFLOP() const -> bool { return (ev.type == CompCostTypeEnum::PRISM_COMP_FLOP); }
+    auto isBatch() const -> bool { return (ev.type == CompCostTypeEnum::PRISM_COMP_BATCH); }
+    auto iops() const -> unsigned { return isBatch() ? ev.iops : isIOP(); }
+    auto flops() const -> unsigned { return isBatch() ? ev.flops : isFLOP(); }
+    auto ops() const -> unsigned { return isBatch() ? ev.iops + ev.flops + ev.otherOps : 1; }
+    /* counts for both single ops and batches */
     const PrismCompEv &ev;
 };
 
@@ -142,6 +185,11 @@ struct CxtEvent
     auto type() const -> CxtType { return ev.type; }
     auto id() const -> PtrVal { return ev.id; }
     auto getName() const -> const char* { return ev.idx + nameBase(); }
+    auto bb() const -> uint32_t { return static_cast<uint32_t>(ev.id); }
+    auto bbInstrs() const -> uint32_t { return (ev.id >> 32) & PRISM_BB_MAX_INSTRS; }
+    auto bbIops() const -> uint32_t { return (ev.id >> 40) & PRISM_BB_MAX_OPS; }
+    auto bbFlops() const -> uint32_t { return (ev.id >> 52) & PRISM_BB_MAX_OPS; }
+    /* only valid for PRISM_CXT_BB, see prismPackBB */
     const PrismCxtEv &ev;
   private:
     const GetNameBase &nameBase;
@@ -251,6 +299,18 @@ inline auto resolveCaps(const capabilities &feCaps, const capabilities &beReqs)
     return caps;
 }
 
+inline auto combineReqs(const capabilities &a, const capabilities &b)
+{
+    /* Requirements of two backends that consume the same event stream:
+     * a capability is enabled if either backend enables it */
+    assert(a.size() == b.size());
+
+    auto caps = a;
+    for (size_t i = 0; i < caps.size(); ++i)
+        caps[i] = std::max(a[i], b[i]);
+    return caps;
+}
+
 }; //end namespace prism
 #endif
 
@@ -28,7 +28,9 @@ enum CompCostTypeEnum
 {
     PRISM_COMP_TYPE_UNDEF = 0,
     PRISM_COMP_IOP,
-    PRISM_COMP_FLOP
+    PRISM_COMP_FLOP,
+    PRISM_COMP_BATCH
+    /* a run of compute ops, counted by type; see PrismCompEv */
 };
 
 enum CompArityEnum
@@ -73,6 +75,10 @@ enum CxtTypeEnum
     PRISM_CXT_FUNC_ENTER,
     PRISM_CXT_FUNC_EXIT,
     PRISM_CXT_THREAD,
+    PRISM_CXT_ROI_BEGIN,
+    PRISM_CXT_ROI_END,
+    PRISM_CXT_SAMPLE_BEGIN,
+    PRISM_CXT_SAMPLE_END,
 };
 
 
@@ -0,0 +1,99 @@
+#ifndef PRISM_RECORDING_H
+#define PRISM_RECORDING_H
+
+#include "EventBuffer.h"
+#include <cstring>
+
+/* Event recordings, written by the 'record' backend
+ * and read back by the 'replay' frontend.
+ *
+ * A recording holds one event stream, i.e. what one backend
+ * thread received, as a sequence of blocks:
+ *
+ *   RecordHeader
+ *   block 0:  RecordBlock, EventBuffer image, names
+ *   block 1:  ...
+ *   index:    uint64_t file offset of each RecordBlock
+ *   RecordFooter
+ *
+ * Each EventBuffer image is a complete EventBuffer whose 'capacity' is
+ * trimmed to what the image holds. Packed images can be handed to a
+ * backend straight out of a mapping of the file. Compact images
+ * (see EventCodec.h) are several times smaller but must be decoded.
+ * The names are the part of the frontend's name arena that the
+ * buffer's context events refer to.
+ *
+ * Everything is 64 byte aligned. The index lets a reader start at
+ * any block without walking the ones before it. */
+
+namespace prism
+{
+
+constexpr char recordMagic[8] = {'P', 'R', 'I', 'S', 'M', 'R', 'E', 'C'};
+constexpr uint32_t recordVersion = 1;
+constexpr uint64_t recordAlign = 64;
+constexpr char recordFilePrefix[] = "prism-record-";
+/* stream 'n' is recorded to <directory>/prism-record-<n> */
+
+struct RecordHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    char padding[recordAlign - 16];
+};
+
+struct RecordBlock
+{
+    uint64_t eventBytes;
+    uint64_t nameBytes;
+    char padding[recordAlign - 16];
+};
+
+struct RecordFooter
+{
+    uint64_t indexOffset;
+    uint64_t blocks;
+    uint64_t events;
+    char magic[8];
+};
+
+static_assert(sizeof(RecordHeader) == recordAlign && sizeof(RecordBlock) == recordAlign,
+              "recording headers must keep blocks aligned");
+
+
+inline auto recordPadded(uint64_t bytes) -> uint64_t
+{
+    return (bytes + recordAlign - 1) & ~(recordAlign - 1);
+}
+
+
+inline auto recordCapabilities() -> capabilities
+{
+    /* What a recording holds, and so what the replay frontend offers.
+     * Enough for SynchroTraceGen and the simpler backends */
+    using namespace capability;
+
+    auto caps = initCaps();
+
+    caps[MEMORY]         = availability::enabled;
+    caps[MEMORY_LDST]    = availability::enabled;
+    caps[MEMORY_SIZE]    = availability::enabled;
+    caps[MEMORY_ADDRESS] = availability::enabled;
+
+    caps[COMPUTE]              = availability::enabled;
+    caps[COMPUTE_INT_OR_FLOAT] = availability::enabled;
+
+    caps[SYNC]      = availability::enabled;
+    caps[SYNC_TYPE] = availability::enabled;
+    caps[SYNC_ARGS] = availability::enabled;
+
+    caps[CONTEXT_INSTRUCTION] = availability::enabled;
+    caps[CONTEXT_THREAD]      = availability::enabled;
+
+    return caps;
+}
+
+}; //end namespace prism
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PRISM_SAMPLING_H
+#define PRISM_SAMPLING_H
+
+#include "Primitive.h"
+
+/* Extrapolation of sampled event streams.
+ *
+ * A sampling frontend only generates events for part of the run,
+ * and brackets each traced window with PRISM_CXT_SAMPLE_BEGIN and
+ * PRISM_CXT_SAMPLE_END context events. The id of each marker is the
+ * guest instruction count at that boundary, so the fraction of the
+ * run that was traced is known from the markers alone. */
+
+namespace prism
+{
+
+class SampleWindow
+{
+  public:
+    auto onCxt(const CxtEvent &ev) -> void
+    {
+        if (ev.type() == PRISM_CXT_SAMPLE_BEGIN)
+        {
+            open = true;
+            begin = ev.id();
+            elapsedInstrs = std::max<uint64_t>(elapsedInstrs, begin);
+        }
+        else if (ev.type() == PRISM_CXT_SAMPLE_END && open)
+        {
+            open = false;
+            sampledInstrs += ev.id() - begin;
+            elapsedInstrs = std::max<uint64_t>(elapsedInstrs, ev.id());
+            ++samplesSeen;
+        }
+    }
+
+    auto merge(const SampleWindow &other) -> void
+    {
+        /* the markers of one frontend may be split across streams */
+        sampledInstrs += other.sampledInstrs;
+        elapsedInstrs = std::max(elapsedInstrs, other.elapsedInstrs);
+        samplesSeen += other.samplesSeen;
+    }
+
+    auto sampled() const -> bool { return samplesSeen > 0; }
+    auto samples() const -> uint64_t { return samplesSeen; }
+    auto sampledInstructions() const -> uint64_t { return sampledInstrs; }
+    auto elapsedInstructions() const -> uint64_t { return elapsedInstrs; }
+
+    auto scale() const -> double
+    {
+        /* 1 for an unsampled stream. The run after the last complete
+         * sample is not accounted for, so the error is at most one period */
+        if (sampledInstrs == 0)
+            return 1.0;
+        return static_cast<double>(elapsedInstrs) / sampledInstrs;
+    }
+
+    auto extrapolate(uint64_t count) const -> uint64_t
+    {
+        return static_cast<uint64_t>(count * scale() + 0.5);
+    }
+
+  private:
+    bool open{false};
+    uint64_t begin{0};
+    uint64_t sampledInstrs{0};
+    uint64_t elapsedInstrs{0};
+    uint64_t samplesSeen{0};
+};
+
+}; //end namespace prism
+
+#endif
@@ -0,0 +1,109 @@
+#include "Staging.hpp"
+#include "PrismLog.hpp"
+#include <cstring>
+#include <cassert>
+
+namespace prism
+{
+
+StagedFrontend::StagedFrontend(FrontendPtr frontend, unsigned depth)
+    : frontend(std::move(frontend))
+    , ring(depth)
+{
+    assert(depth > 0);
+
+    for (auto &slot : ring)
+        slot.storage.resize(sizeof(EventBuffer) +
+                            PRISM_EVENTS_BUFFER_SIZE * sizeof(PrismEvVariant));
+
+    FrontendIface::nameBase = [&]{ return ring[head].names; };
+    stagingLoop = std::thread{&StagedFrontend::stageEventsLoop, this};
+}
+
+
+StagedFrontend::~StagedFrontend()
+{
+    stagingLoop.join();
+
+    PrismLog::info("staging    : {} buffers staged, max occupancy {}/{}",
+                   stagedBuffers, maxStaged, ring.size());
+    PrismLog::info("staging    : {} frontend stalls (ring full), "
+                   "{} backend stalls (ring empty)",
+                   frontendStalls, backendStalls);
+}
+
+
+auto StagedFrontend::acquireBuffer() -> EventBufferPtr
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (staged == 0 && finished == false)
+    {
+        ++backendStalls;
+        notEmpty.wait(lock, [&]{ return staged > 0 || finished; });
+    }
+
+    if (staged == 0)
+        return nullptr;
+    else
+        return EventBufferPtr(ring[head].events());
+}
+
+
+auto StagedFrontend::releaseBuffer(EventBufferPtr buf) -> void
+{
+    assert(buf.get() == ring[head].events());
+    buf.release();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    head = (head + 1) % ring.size();
+    --staged;
+    notFull.notify_one();
+}
+
+
+auto StagedFrontend::stageEventsLoop() -> void
+{
+    EventBufferPtr buf = frontend->acquireBuffer();
+
+    while (buf != nullptr)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (staged == ring.size())
+        {
+            ++frontendStalls;
+            notFull.wait(lock, [&]{ return staged < ring.size(); });
+        }
+        lock.unlock();
+
+        /* Only the staging thread writes to the tail,
+         * and the backend never touches it until it is published */
+        StagingBuffer &slot = ring[tail];
+        auto bytes = (buf->encoding == PRISM_EVENTS_COLUMNS) ?
+                     prismEventBufferSize(buf->encoding, buf->capacity) :
+                     prismEventBufferSize(buf->encoding, buf->used);
+        if (slot.storage.size() < bytes)
+            slot.storage.resize(bytes);
+        prismEventBufferCopy(slot.events(), buf.get());
+        if (frontend->nameBase)
+            std::memcpy(slot.names, frontend->nameBase(), sizeof(slot.names));
+
+        frontend->releaseBuffer(std::move(buf));
+
+        lock.lock();
+        tail = (tail + 1) % ring.size();
+        ++staged;
+        ++stagedBuffers;
+        maxStaged = std::max(maxStaged, staged);
+        notEmpty.notify_one();
+        lock.unlock();
+
+        buf = frontend->acquireBuffer();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    finished = true;
+    notEmpty.notify_one();
+}
+
+}; //end namespace prism
@@ -0,0 +1,69 @@
+#ifndef PRISM_STAGING_H
+#define PRISM_STAGING_H
+
+#include "Frontends.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace prism
+{
+
+class StagedFrontend : public FrontendIface
+{
+    /* Decouples the frontend from the backend with a ring of
+     * Prism-owned staging buffers.
+     *
+     * A separate thread acquires buffers from the wrapped frontend,
+     * copies the events (and any context names) into a free staging
+     * buffer, and releases the frontend buffer right away.
+     * For shared memory frontends this hands the slot back to the
+     * instrumented program without waiting on the backend.
+     * The backend then drains the staging ring at its own pace.
+     *
+     * Staging trades memory for frontend throughput:
+     * each staging buffer holds one EventBuffer and one NameBuffer.
+     * Stall counts are reported on destruction to help size the ring. */
+
+    struct StagingBuffer
+    {
+        std::vector<char> storage;
+        /* an EventBuffer, grown to fit the largest buffer staged so far.
+         * Only the used part is copied, in the frontend's encoding */
+
+        char names[PRISM_NAMES_BUFFER_SIZE];
+
+        auto events() -> EventBuffer* { return reinterpret_cast<EventBuffer*>(storage.data()); }
+    };
+
+  public:
+    StagedFrontend(FrontendPtr frontend, unsigned depth);
+    ~StagedFrontend() override;
+
+    virtual auto acquireBuffer() -> EventBufferPtr override final;
+    virtual auto releaseBuffer(EventBufferPtr) -> void override final;
+
+  private:
+    auto stageEventsLoop() -> void;
+
+    FrontendPtr frontend;
+    std::vector<StagingBuffer> ring;
+    unsigned head{0}, tail{0}, staged{0};
+    bool finished{false};
+    /* ring indices and fill count */
+
+    std::mutex mtx;
+    std::condition_variable notFull, notEmpty;
+
+    unsigned long stagedBuffers{0};
+    unsigned long frontendStalls{0};
+    unsigned long backendStalls{0};
+    unsigned maxStaged{0};
+    /* statistics */
+
+    std::thread stagingLoop;
+};
+
+}; //end namespace prism
+
+#endif
@@ -0,0 +1,205 @@
+#include "Stats.hpp"
+#include "PrismLog.hpp"
+#include <cassert>
+
+namespace prism
+{
+
+namespace
+{
+
+const char *tagNames[StreamCounters::tags] = {"undef", "mem", "comp", "cf", "cxt", "sync"};
+
+auto seconds(uint64_t ns) -> double
+{
+    return ns / 1e9;
+}
+
+auto share(uint64_t part, uint64_t whole) -> double
+{
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+}; //end namespace
+
+
+constexpr unsigned StreamCounters::occupancyBuckets;
+constexpr unsigned StreamCounters::tags;
+
+
+//-----------------------------------------------------------------------------
+/** StreamCounters **/
+auto StreamCounters::count(const EventBuffer &buf) -> void
+{
+    bump(buffers, 1);
+
+    auto bucket = buf.capacity > 0 ? buf.used * occupancyBuckets / buf.capacity : occupancyBuckets;
+    bump(occupancy[bucket < occupancyBuckets ? bucket : occupancyBuckets - 1], 1);
+
+    uint64_t perTag[tags] = {};
+    if (buf.encoding == PRISM_EVENTS_COLUMNS)
+    {
+        /* the column fill counts already hold the numbers */
+        const EventColumns *columns = prismColumns(&buf);
+        perTag[PRISM_MEM_TAG]  = columns->mem;
+        perTag[PRISM_COMP_TAG] = columns->comp;
+        perTag[PRISM_CF_TAG]   = columns->cf;
+        perTag[PRISM_CXT_TAG]  = columns->cxt;
+        perTag[PRISM_SYNC_TAG] = columns->sync;
+    }
+    else
+    {
+        for (decltype(buf.used) i = 0; i < buf.used; ++i)
+            ++perTag[buf.events[i].tag < tags ? buf.events[i].tag : PRISM_EV_UNDEF];
+    }
+
+    for (unsigned t = 0; t < tags; ++t)
+        if (perTag[t] > 0)
+            bump(events[t], perTag[t]);
+}
+
+
+//-----------------------------------------------------------------------------
+/** PipelineStats **/
+auto PipelineStats::Totals::eventsTotal() const -> uint64_t
+{
+    uint64_t total = 0;
+    for (auto n : events)
+        total += n;
+    return total;
+}
+
+
+PipelineStats::PipelineStats(const StatsConfig &config)
+    : config(config)
+    , start(std::chrono::steady_clock::now())
+{
+    assert(config.enabled == true);
+
+    if (config.path.empty() == false)
+    {
+        file.open(config.path, std::ios::out | std::ios::trunc);
+        if (file.good() == false)
+            PrismLog::fatal("Could not open stats file: " + config.path);
+    }
+
+    if (config.interval > 0)
+        reporter = std::thread{&PipelineStats::reportLoop, this};
+}
+
+
+PipelineStats::~PipelineStats()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+    }
+    wake.notify_all();
+    if (reporter.joinable())
+        reporter.join();
+
+    auto t = totals();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto events = t.eventsTotal();
+    auto busy = t.acquireNs + t.flushNs + t.releaseNs;
+
+    /* time is summed over every backend thread */
+    emit(fmt::format("stats      : {} events in {} buffers, {:.0f} events/s",
+                     events, t.buffers, elapsed > 0 ? events / elapsed : 0.0));
+    emit(fmt::format("stats      : acquire {:.3f}s ({:.1f}%), backend {:.3f}s ({:.1f}%), "
+                     "release {:.3f}s ({:.1f}%)",
+                     seconds(t.acquireNs), share(t.acquireNs, busy),
+                     seconds(t.flushNs), share(t.flushNs, busy),
+                     seconds(t.releaseNs), share(t.releaseNs, busy)));
+
+    std::string perTag;
+    for (unsigned tag = PRISM_MEM_TAG; tag < StreamCounters::tags; ++tag)
+        perTag += fmt::format(" {} {} ({:.0f}/s)", tagNames[tag], t.events[tag],
+                              elapsed > 0 ? t.events[tag] / elapsed : 0.0);
+    emit("stats      :" + perTag);
+
+    std::string occupancy;
+    for (unsigned b = 0; b < StreamCounters::occupancyBuckets; ++b)
+        occupancy += fmt::format(" {}", t.occupancy[b]);
+    emit("stats      : buffer occupancy by tenths:" + occupancy);
+}
+
+
+auto PipelineStats::stream() -> StreamCounters*
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    streams.emplace_back();
+    return &streams.back();
+}
+
+
+auto PipelineStats::totals() -> Totals
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    Totals t;
+    for (const auto &s : streams)
+    {
+        t.acquireNs += s.acquireNs.load(std::memory_order_relaxed);
+        t.flushNs   += s.flushNs.load(std::memory_order_relaxed);
+        t.releaseNs += s.releaseNs.load(std::memory_order_relaxed);
+        t.buffers   += s.buffers.load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < StreamCounters::tags; ++i)
+            t.events[i] += s.events[i].load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < StreamCounters::occupancyBuckets; ++i)
+            t.occupancy[i] += s.occupancy[i].load(std::memory_order_relaxed);
+    }
+
+    return t;
+}
+
+
+auto PipelineStats::reportLoop() -> void
+{
+    /* one line per interval, with rates since the previous line */
+
+    Totals prev;
+    auto interval = std::chrono::seconds(config.interval);
+    auto next = start + interval;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (wake.wait_until(lock, next, [&]{ return done; }))
+                return;
+        }
+
+        auto t = totals();
+        auto elapsed = std::chrono::duration<double>(next - start).count();
+        auto secs = double(config.interval);
+        auto busy = (t.acquireNs - prev.acquireNs) + (t.flushNs - prev.flushNs) +
+                    (t.releaseNs - prev.releaseNs);
+
+        std::string perTag;
+        for (unsigned tag = PRISM_MEM_TAG; tag < StreamCounters::tags; ++tag)
+            perTag += fmt::format(" {} {:.0f}/s", tagNames[tag], (t.events[tag] - prev.events[tag]) / secs);
+
+        emit(fmt::format("stats      : {:.0f}s {:.0f} events/s, {:.0f} buffers/s, "
+                         "acquire {:.1f}% backend {:.1f}% release {:.1f}% |{}",
+                         elapsed, (t.eventsTotal() - prev.eventsTotal()) / secs,
+                         (t.buffers - prev.buffers) / secs,
+                         share(t.acquireNs - prev.acquireNs, busy),
+                         share(t.flushNs - prev.flushNs, busy),
+                         share(t.releaseNs - prev.releaseNs, busy), perTag));
+
+        prev = t;
+        next += interval;
+    }
+}
+
+
+auto PipelineStats::emit(const std::string &line) -> void
+{
+    if (file.is_open())
+        file << line << std::endl;
+    else
+        PrismLog::info(line);
+}
+
+}; //end namespace prism
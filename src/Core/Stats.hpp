@@ -0,0 +1,132 @@
+#ifndef PRISM_STATS_H
+#define PRISM_STATS_H
+
+#include "EventBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace prism
+{
+
+struct StatsConfig
+{
+    bool enabled{false};
+    unsigned interval{0};
+    /* seconds between reports, 0 for the summary at exit only */
+    std::string path;
+    /* report to this file instead of the log */
+};
+
+
+struct StreamCounters
+{
+    /* Pipeline counters of one backend thread.
+     * Only the owning thread writes them; the reporter reads them */
+
+    using Counter = std::atomic<uint64_t>;
+    static constexpr unsigned occupancyBuckets = 10;
+    static constexpr unsigned tags = PRISM_SYNC_TAG + 1;
+
+    Counter acquireNs{0};
+    /* blocked in FrontendIface::acquireBuffer, i.e. frontend starvation */
+    Counter flushNs{0};
+    /* in the backend */
+    Counter releaseNs{0};
+    /* in FrontendIface::releaseBuffer */
+
+    Counter buffers{0};
+    Counter events[tags] = {};
+    Counter occupancy[occupancyBuckets] = {};
+    /* buffers by fill level, in tenths of their capacity */
+
+    auto count(const EventBuffer &buf) -> void;
+
+    static auto bump(Counter &c, uint64_t n) -> void
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+
+class StageClock
+{
+    /* Charges the time since the previous lap to a stage.
+     * Does nothing without counters, so the core can always use it */
+
+    using clock = std::chrono::steady_clock;
+
+  public:
+    StageClock(StreamCounters *counters)
+        : counters(counters)
+    {
+        if (counters != nullptr)
+            last = clock::now();
+    }
+
+    auto lap(StreamCounters::Counter StreamCounters::*stage) -> void
+    {
+        if (counters == nullptr)
+            return;
+
+        auto now = clock::now();
+        StreamCounters::bump(counters->*stage,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+        last = now;
+    }
+
+  private:
+    StreamCounters *counters;
+    clock::time_point last;
+};
+
+
+class PipelineStats
+{
+    /* Collects the counters of every backend thread.
+     * A reporter thread writes a line every 'interval' seconds
+     * with the rates since the previous line.
+     * The summary is written on destruction, after the threads are done */
+
+    struct Totals
+    {
+        uint64_t acquireNs{0}, flushNs{0}, releaseNs{0};
+        uint64_t buffers{0};
+        uint64_t events[StreamCounters::tags] = {};
+        uint64_t occupancy[StreamCounters::occupancyBuckets] = {};
+
+        auto eventsTotal() const -> uint64_t;
+    };
+
+  public:
+    PipelineStats(const StatsConfig &config);
+    ~PipelineStats();
+
+    auto stream() -> StreamCounters*;
+    /* counters for a new backend thread */
+
+  private:
+    auto totals() -> Totals;
+    auto reportLoop() -> void;
+    auto emit(const std::string &line) -> void;
+
+    const StatsConfig config;
+    std::ofstream file;
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::deque<StreamCounters> streams;
+    bool done{false};
+    std::thread reporter;
+
+    std::chrono::steady_clock::time_point start;
+};
+
+}; //end namespace prism
+
+#endif
@@ -1,4 +1,8 @@
 #include "Config.hpp"
+#include "Staging.hpp"
+#include "Merging.hpp"
+#include "FanOut.hpp"
+#include "Stats.hpp"
 #include "EventBuffer.h"
 
 #include "Frontends/AvailableFrontends.hpp"
@@ -6,6 +10,7 @@
 #include "Backends/SynchroTraceGen/EventHandlers.hpp"
 #include "Backends/SimpleCount/Handler.hpp"
 #include "Backends/SigilClassic/Handler.hpp"
+#include "Backends/Record/Record.hpp"
 
 using namespace PrismLog;
 using namespace prism;
@@ -27,6 +32,12 @@ int main(int argc, char* argv[])
         .registerFrontend("perf",
                           {startPerfPT,
                           perfPTCapabilities()})
+        .registerFrontend("synthetic",
+                          {startSynthetic,
+                          syntheticCapabilities()})
+        .registerFrontend("replay",
+                          {startReplay,
+                          replayCapabilities()})
         .registerBackend("stgen",
                          []{return std::make_unique<::STGen::EventHandlers>();},
                          ::STGen::onParse,
@@ -42,6 +53,11 @@ int main(int argc, char* argv[])
                          {},
                          {},
                          initCaps())
+        .registerBackend("record",
+                         []{return std::make_unique<::Record::Handler>();},
+                         ::Record::onParse,
+                         ::Record::onExit,
+                         ::Record::requirements())
         .registerBackend("null",
                          []{return std::make_unique<::BackendIface>();},
                          {},
@@ -60,52 +76,48 @@ auto flushToBackend(BackendIface &be,
                     const EventBuffer &buf,
                     const GetNameBase &nameBase) -> void
 {
-    for (decltype(buf.used) i = 0; i < buf.used; ++i)
-    {
-        const PrismEvVariant &ev = buf.events[i];
-
-        switch (ev.tag)
-        {
-        case EvTagEnum::PRISM_MEM_TAG:
-            be.onMemEv({ev.mem});
-            break;
-        case EvTagEnum::PRISM_COMP_TAG:
-            be.onCompEv({ev.comp});
-            break;
-        case EvTagEnum::PRISM_SYNC_TAG:
-            be.onSyncEv({ev.sync});
-            break;
-        case EvTagEnum::PRISM_CXT_TAG:
-            be.onCxtEv({ev.cxt, nameBase});
-            break;
-        case EvTagEnum::PRISM_CF_TAG:
-            be.onCFEv(ev.cf);
-            break;
-        default:
-            fatal("Received unhandled event in " __FILE__);
-        }
-    }
+    /* one virtual call per buffer;
+     * batched backends devirtualize the per-event dispatch */
+    be.onEvents(buf, nameBase);
 }
 
 
 auto consumeEvents(BackendIfaceGenerator createBEIface,
-                   FrontendIfaceGenerator createFEIface) -> void
+                   FrontendIfaceGenerator createFEIface,
+                   unsigned stagingBuffers,
+                   PipelineStats *stats) -> void
 {
     BackendPtr backendIface  = createBEIface();
     FrontendPtr frontendIface = createFEIface();
     /* per-thread frontend/backend interfaces
      * each backend interface needs a frontend interface to communicate with */
 
+    if (stagingBuffers > 0)
+        frontendIface = std::make_unique<StagedFrontend>(std::move(frontendIface),
+                                                         stagingBuffers);
+    /* release frontend buffers before the backend processes them */
+
+    StreamCounters *counters = stats != nullptr ? stats->stream() : nullptr;
+    StageClock clock(counters);
+    /* no-ops without stats */
+
     EventBufferPtr buf = frontendIface->acquireBuffer();
+    clock.lap(&StreamCounters::acquireNs);
 
     while (buf != nullptr) // consume events until there's nothing left
     {
+        if (counters != nullptr)
+            counters->count(*buf);
+
         flushToBackend(*backendIface, *buf,
                        frontendIface->nameBase);
+        clock.lap(&StreamCounters::flushNs);
 
         /* acquire a new buffer */
         frontendIface->releaseBuffer(std::move(buf));
+        clock.lap(&StreamCounters::releaseNs);
         buf = frontendIface->acquireBuffer();
+        clock.lap(&StreamCounters::acquireNs);
     }
 }
 
@@ -115,41 +127,85 @@ auto startPrism(const Config& config) -> int
     using std::chrono::high_resolution_clock;
 
     auto threads       = config.threads();
-    auto backend       = config.backend();
+    auto backends      = config.backends();
     auto startFrontend = config.startFrontend();
     auto timed         = config.timed();
+    auto staging       = config.stagingBuffers();
+    auto merge         = config.mergeStreams();
+    auto fanout        = config.fanoutThreads();
+    auto statsConfig   = config.stats();
 
     if (threads < 1)
         fatal("Invalid number of backend threads");
 
-    if (backend.parser)
-        backend.parser(backend.args);
-    else if (backend.args.size() > 0)
-        fatal("Backend arguments provided, but Backend has no parser");
+    for (const auto &backend : backends)
+    {
+        if (backend.parser)
+            backend.parser(backend.args);
+        else if (backend.args.size() > 0)
+            fatal("Backend arguments provided, but Backend has no parser");
+    }
 
     info("executable : " + config.executablePrintable());
     info("frontend   : " + (config.frontendPrintable().empty() ? "default" : config.frontendPrintable()));
     info("backend    : " + config.backendPrintable());
     info("threads    : " + config.threadsPrintable());
     info("timed      : " + (timed ? std::string("on") : std::string("off")));
+    info("ipc        : " + config.ipcPrintable());
+    info("staging    : " + (staging > 0 ? std::to_string(staging) : std::string("off")));
+    info("merge      : " + (merge ? std::string("on") : std::string("off")));
+    info("stats      : " + (statsConfig.enabled == false ? std::string("off") :
+                              statsConfig.interval > 0 ? "every " + std::to_string(statsConfig.interval) + "s" :
+                              std::string("at exit")));
+    if (backends.size() > 1)
+        info("fanout     : " + (fanout ? std::string("threads") : std::string("sequential")));
 
     /* start frontend only once and get its interface */
     auto frontendIfaceGenerator = startFrontend();
+    auto workers = threads;
+    if (merge == true)
+    {
+        /* a single backend thread reads every frontend stream,
+         * in timestamp order */
+        auto streamGenerator = frontendIfaceGenerator;
+        frontendIfaceGenerator = [=]{ std::vector<FrontendPtr> streams;
+                                      for(auto i = 0; i < threads; ++i)
+                                          streams.emplace_back(streamGenerator());
+                                      return std::make_unique<MergedFrontend>(std::move(streams)); };
+        workers = 1;
+    }
+
+    /* every backend thread runs one instance of each backend */
+    auto backendIfaceGenerator = backends.front().generator;
+    if (backends.size() > 1)
+        backendIfaceGenerator = [=]{ std::vector<BackendPtr> instances;
+                                     for (const auto &backend : backends)
+                                         instances.emplace_back(backend.generator());
+                                     return std::make_unique<FanOutBackend>(std::move(instances), fanout); };
+
+    std::unique_ptr<PipelineStats> stats;
+    if (statsConfig.enabled == true)
+        stats = std::make_unique<PipelineStats>(statsConfig);
+
     std::vector<std::thread> eventStreams;
-    for(auto i = 0; i < threads; ++i)
+    for(auto i = 0; i < workers; ++i)
         eventStreams.emplace_back(std::thread(consumeEvents,
-                                              backend.generator,
-                                              frontendIfaceGenerator));
+                                              backendIfaceGenerator,
+                                              frontendIfaceGenerator,
+                                              staging,
+                                              stats.get()));
 
     high_resolution_clock::time_point start, end;
     if (timed == true)
         start = high_resolution_clock::now();
 
     /* wait for event handling to finish and then clean up */
-    for(auto i = 0; i < threads; ++i)
+    for(auto i = 0; i < workers; ++i)
         eventStreams[i].join();
-    if (backend.finish)
-        backend.finish();
+    stats.reset();
+    for (const auto &backend : backends)
+        if (backend.finish)
+            backend.finish();
 
     if (timed == true)
     {
@@ -0,0 +1,288 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#include "Core/EventCodec.h"
+
+/* Buffers are allocated the same way as in the shared memory segment,
+ * see prismIPCLayout in CommonShmemIPC.h */
+struct TestBuffer
+{
+    std::vector<uint64_t> storage;
+
+    TestBuffer(uint32_t encoding, uint32_t capacity)
+        : storage(prismEventBufferSize(encoding, capacity) / sizeof(uint64_t) + 1)
+    {
+        get()->used     = 0;
+        get()->encoding = encoding;
+        get()->capacity = capacity;
+    }
+
+    auto get() -> EventBuffer* { return reinterpret_cast<EventBuffer*>(storage.data()); }
+};
+
+
+auto randomEvent() -> PrismEvVariant
+{
+    /* Mostly small strides with the occasional jump,
+     * like a real instruction and memory stream */
+    static PtrVal addr = 0x7fff0000;
+    static PtrVal instr = 0x400000;
+
+    PrismEvVariant ev = {};
+    switch (rand() % 5)
+    {
+    case 0:
+        ev.tag = PRISM_MEM_TAG;
+        ev.mem.type = rand() % 4;
+        ev.mem.size = (rand() % 8 == 0) ? (rand() % 300) : (1 << (rand() % 4));
+        addr += (rand() % 16 == 0) ? (PtrVal)rand() << 20 : (rand() % 64) - 32;
+        ev.mem.begin_addr = addr;
+        break;
+    case 1:
+        ev.tag = PRISM_COMP_TAG;
+        ev.comp.type = rand() % 4;
+        ev.comp.arity = rand() % 9;
+        ev.comp.op = rand() % 256;
+        ev.comp.size = rand() % 256;
+        break;
+    case 2:
+        ev.tag = PRISM_CF_TAG;
+        ev.cf.type = rand() % 40;
+        break;
+    case 3:
+        ev.tag = PRISM_CXT_TAG;
+        ev.cxt.type = rand() % 6;
+        if (ev.cxt.type == PRISM_CXT_INSTR)
+        {
+            instr += (rand() % 32 == 0) ? -(PtrVal)(rand() % 4096) : (rand() % 8);
+            ev.cxt.id = instr;
+        }
+        else if (ev.cxt.type == PRISM_CXT_FUNC_ENTER || ev.cxt.type == PRISM_CXT_FUNC_EXIT)
+        {
+            ev.cxt.idx = rand() % 4096;
+            ev.cxt.len = rand() % 64;
+        }
+        else
+        {
+            ev.cxt.id = (PtrVal)rand() << 16;
+        }
+        break;
+    default:
+        ev.tag = PRISM_SYNC_TAG;
+        ev.sync.type = rand() % 40;
+        ev.sync.data[0] = rand() - RAND_MAX / 2;
+        ev.sync.data[1] = (SyncID)rand() << 32;
+        break;
+    }
+
+    return ev;
+}
+
+
+auto encodeAll(EventBuffer *buf, const std::vector<PrismEvVariant> &events) -> size_t
+{
+    /* Returns how many events fit */
+    PrismEncoder enc;
+    prismEncoderInit(&enc, buf);
+    size_t i = 0;
+    for (; i < events.size() && prismEncoderFull(&enc) == 0; ++i)
+        prismEncodeEvent(&enc, &events[i]);
+    prismEncoderFinish(&enc);
+    return i;
+}
+
+
+auto roundTrip(const std::vector<PrismEvVariant> &events) -> void
+{
+    TestBuffer compact(PRISM_EVENTS_COMPACT, events.size() + 64);
+    REQUIRE(encodeAll(compact.get(), events) == events.size());
+    REQUIRE(compact.get()->used == events.size());
+
+    TestBuffer packed(PRISM_EVENTS_PACKED, events.size());
+    REQUIRE(prismDecodeCompact(compact.get(), packed.get()) == 1);
+    REQUIRE(packed.get()->used == events.size());
+    REQUIRE(packed.get()->encoding == PRISM_EVENTS_PACKED);
+
+    for (size_t i = 0; i < events.size(); ++i)
+        REQUIRE(memcmp(&packed.get()->events[i], &events[i], sizeof(PrismEvVariant)) == 0);
+}
+
+
+TEST_CASE("compact events decode to the original events", "[EventCodecRoundTrip]")
+{
+    SECTION("empty buffer")
+    {
+        roundTrip({});
+    }
+
+    SECTION("random event stream")
+    {
+        srand(time(NULL));
+        std::vector<PrismEvVariant> events;
+        for (int i = 0; i < 100000; ++i)
+            events.push_back(randomEvent());
+        roundTrip(events);
+    }
+
+    SECTION("edge values")
+    {
+        std::vector<PrismEvVariant> events;
+        PrismEvVariant ev = {};
+
+        ev.tag = PRISM_MEM_TAG;
+        for (PtrVal addr : {(PtrVal)0, ~(PtrVal)0, (PtrVal)1, ~(PtrVal)0 >> 1, (PtrVal)0})
+        {
+            for (ByteCount size : {0, 1, 64, 65, 0xffff})
+            {
+                ev.mem.type = PRISM_MEM_STORE;
+                ev.mem.begin_addr = addr;
+                ev.mem.size = size;
+                events.push_back(ev);
+            }
+        }
+
+        ev = {};
+        ev.tag = PRISM_CXT_TAG;
+        ev.cxt.type = PRISM_CXT_INSTR;
+        for (PtrVal addr : {~(PtrVal)0, (PtrVal)0, ~(PtrVal)0 >> 1})
+        {
+            ev.cxt.id = addr;
+            events.push_back(ev);
+        }
+        ev.cxt.type = PRISM_CXT_FUNC_EXIT;
+        ev.cxt.idx = 0xffffffff;
+        ev.cxt.len = 0xffffffff;
+        events.push_back(ev);
+        ev = {};
+        ev.tag = PRISM_CXT_TAG;
+        ev.cxt.type = PRISM_CXT_BB;
+        ev.cxt.id = prismPackBB(0xffffffff, 1000, 5000, 5000);
+        events.push_back(ev);
+
+        ev = {};
+        ev.tag = PRISM_SYNC_TAG;
+        ev.sync.type = 0xff;
+        ev.sync.data[0] = INTPTR_MIN;
+        ev.sync.data[1] = INTPTR_MAX;
+        events.push_back(ev);
+
+        ev = {};
+        ev.tag = PRISM_COMP_TAG;
+        ev.comp.type = 0xff;
+        ev.comp.arity = 0xff;
+        ev.comp.op = 0xff;
+        ev.comp.size = 0xff;
+        events.push_back(ev);
+        ev.comp.type = PRISM_COMP_BATCH;
+        ev.comp.iops = 0xff;
+        ev.comp.flops = 0;
+        ev.comp.otherOps = 1;
+        events.push_back(ev);
+
+        roundTrip(events);
+    }
+}
+
+
+TEST_CASE("compact buffers hold more events", "[EventCodecCapacity]")
+{
+    /* An instruction followed by a nearby load,
+     * the common case for the Valgrind frontend */
+    std::vector<PrismEvVariant> events;
+    PrismEvVariant instr = {}, load = {};
+    instr.tag = PRISM_CXT_TAG;
+    instr.cxt.type = PRISM_CXT_INSTR;
+    load.tag = PRISM_MEM_TAG;
+    load.mem.type = PRISM_MEM_LOAD;
+    load.mem.size = 8;
+    for (int i = 0; i < 100000; ++i)
+    {
+        instr.cxt.id = 0x400000 + (PtrVal)i * 4;
+        load.mem.begin_addr = 0x7fff0000 + (PtrVal)i * 8;
+        events.push_back(instr);
+        events.push_back(load);
+    }
+
+    const uint32_t capacity = 4096;
+    TestBuffer compact(PRISM_EVENTS_COMPACT, capacity);
+    REQUIRE(encodeAll(compact.get(), events) >= 3 * capacity);
+}
+
+
+TEST_CASE("corrupt compact buffers are rejected", "[EventCodecCorrupt]")
+{
+    std::vector<PrismEvVariant> events;
+    for (int i = 0; i < 100; ++i)
+        events.push_back(randomEvent());
+
+    TestBuffer compact(PRISM_EVENTS_COMPACT, events.size());
+    encodeAll(compact.get(), events);
+    TestBuffer packed(PRISM_EVENTS_PACKED, events.size() + 1);
+
+    SECTION("truncated stream")
+    {
+        prismCompact(compact.get())->bytes -= 1;
+        REQUIRE(prismDecodeCompact(compact.get(), packed.get()) == 0);
+    }
+
+    SECTION("more events than encoded")
+    {
+        compact.get()->used += 1;
+        REQUIRE(prismDecodeCompact(compact.get(), packed.get()) == 0);
+    }
+
+    SECTION("stream length past the buffer")
+    {
+        prismCompact(compact.get())->bytes = prismCompactCapacity(compact.get()) + 1;
+        REQUIRE(prismDecodeCompact(compact.get(), packed.get()) == 0);
+    }
+}
+
+
+TEST_CASE("basic block counts are packed into the context id", "[EventCodecBB]")
+{
+    PrismCxtEv ev;
+    ev.type = PRISM_CXT_BB;
+    GetNameBase nameBase = []{ return static_cast<const char*>(nullptr); };
+
+    ev.id = prismPackBB(123456, 17, 40, 3);
+    prism::CxtEvent bb{ev, nameBase};
+    REQUIRE(bb.bb() == 123456);
+    REQUIRE(bb.bbInstrs() == 17);
+    REQUIRE(bb.bbIops() == 40);
+    REQUIRE(bb.bbFlops() == 3);
+
+    /* counts saturate instead of spilling into the next field */
+    ev.id = prismPackBB(0xffffffff, 1000, 0, 5000);
+    REQUIRE(bb.bb() == 0xffffffff);
+    REQUIRE(bb.bbInstrs() == PRISM_BB_MAX_INSTRS);
+    REQUIRE(bb.bbIops() == 0);
+    REQUIRE(bb.bbFlops() == PRISM_BB_MAX_OPS);
+}
+
+
+TEST_CASE("compute batches count their ops", "[EventCodecCompBatch]")
+{
+    PrismCompEv ev = {};
+    ev.type = PRISM_COMP_FLOP;
+    ev.arity = PRISM_COMP_BINARY;
+    prism::CompEvent single{ev};
+    REQUIRE(single.isBatch() == false);
+    REQUIRE(single.iops() == 0);
+    REQUIRE(single.flops() == 1);
+    REQUIRE(single.ops() == 1);
+
+    ev.type = PRISM_COMP_BATCH;
+    ev.iops = 200;
+    ev.flops = 3;
+    ev.otherOps = 0xff;
+    prism::CompEvent batch{ev};
+    REQUIRE(batch.isBatch() == true);
+    REQUIRE(batch.iops() == 200);
+    REQUIRE(batch.flops() == 3);
+    REQUIRE(batch.ops() == 458);
+}
@@ -0,0 +1,98 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <atomic>
+#include <vector>
+
+#include "Core/FanOut.hpp"
+
+using prism::FanOutBackend;
+
+
+class CountingBackend : public BackendIface
+{
+    /* Sums the addresses of the memory events it sees */
+
+  public:
+    CountingBackend(std::atomic<unsigned> &busy) : busy(busy) {}
+
+    auto onEvents(const EventBuffer &buf, const GetNameBase &nameBase) -> void override
+    {
+        /* may run on a fan-out thread, so no REQUIREs in here */
+        ++busy;
+        names = nameBase();
+        for (decltype(buf.used) i = 0; i < buf.used; ++i)
+            sum += buf.events[i].mem.begin_addr;
+        events += buf.used;
+        ++buffers;
+        --busy;
+    }
+
+    std::atomic<unsigned> &busy;
+    unsigned long long sum{0};
+    unsigned long long events{0};
+    unsigned buffers{0};
+    const char *names{nullptr};
+};
+
+
+auto fanOut(bool threaded, unsigned backends)
+{
+    std::atomic<unsigned> busy{0};
+    std::vector<CountingBackend*> seen;
+    std::vector<BackendPtr> instances;
+    for (unsigned i = 0; i < backends; ++i)
+    {
+        seen.push_back(new CountingBackend(busy));
+        instances.emplace_back(seen.back());
+    }
+
+    std::vector<uint64_t> storage(prismEventBufferSize(PRISM_EVENTS_PACKED, 64) / sizeof(uint64_t) + 1);
+    auto buf = reinterpret_cast<EventBuffer*>(storage.data());
+    buf->encoding = PRISM_EVENTS_PACKED;
+    buf->capacity = 64;
+    const char names[] = "names";
+    GetNameBase nameBase = [&]{ return names; };
+
+    FanOutBackend fanout(std::move(instances), threaded);
+
+    unsigned long long expected = 0;
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        buf->used = n % 64;
+        for (decltype(buf->used) i = 0; i < buf->used; ++i)
+        {
+            buf->events[i].tag = PRISM_MEM_TAG;
+            buf->events[i].mem.begin_addr = n * 64 + i;
+            expected += n * 64 + i;
+        }
+
+        fanout.onEvents(*buf, nameBase);
+
+        /* every backend is done before the buffer is handed back */
+        REQUIRE(busy == 0);
+        for (auto be : seen)
+            REQUIRE(be->buffers == n + 1);
+    }
+
+    for (auto be : seen)
+    {
+        REQUIRE(be->sum == expected);
+        REQUIRE(be->names == names);
+    }
+}
+
+
+TEST_CASE("every backend sees every buffer", "[fanout]")
+{
+    fanOut(false, 1);
+    fanOut(false, 3);
+}
+
+
+TEST_CASE("threaded fan-out returns once every backend is done", "[fanout]")
+{
+    fanOut(true, 1);
+    fanOut(true, 2);
+    fanOut(true, 4);
+}
@@ -0,0 +1,279 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <vector>
+#include <string>
+
+#include "Core/Merging.hpp"
+
+decltype(FrontendIface::uidCount) FrontendIface::uidCount{0};
+
+using prism::MergedFrontend;
+
+
+struct TestEvent
+{
+    uint64_t time;
+    PrismEvVariant ev;
+};
+
+
+auto memEvent(uint64_t time, PtrVal addr) -> TestEvent
+{
+    TestEvent t;
+    t.time = time;
+    t.ev.tag = PRISM_MEM_TAG;
+    t.ev.mem.type = PRISM_MEM_LOAD;
+    t.ev.mem.begin_addr = addr;
+    t.ev.mem.size = 8;
+    return t;
+}
+
+
+auto swapEvent(uint64_t time, SyncID thread) -> TestEvent
+{
+    TestEvent t;
+    t.time = time;
+    t.ev.tag = PRISM_SYNC_TAG;
+    t.ev.sync.type = PRISM_SYNC_SWAP;
+    t.ev.sync.data[0] = thread;
+    t.ev.sync.data[1] = 0;
+    return t;
+}
+
+
+class TestFrontend : public FrontendIface
+{
+    /* Hands out a fixed list of timestamped buffers */
+
+  public:
+    TestFrontend(std::vector<std::vector<TestEvent>> buffers,
+                 uint32_t encoding = PRISM_EVENTS_PACKED,
+                 std::string arena = "")
+        : buffers(std::move(buffers))
+        , encoding(encoding)
+        , arena(std::move(arena))
+    {
+        FrontendIface::nameBase = [&]{ return this->arena.data(); };
+        FrontendIface::timestamps = [&]{
+            return reinterpret_cast<const TimestampBuffer*>(times.data()); };
+    }
+
+    auto acquireBuffer() -> EventBufferPtr override
+    {
+        REQUIRE(acquired == false);
+        if (next == buffers.size())
+            return nullptr;
+
+        const auto &events = buffers[next++];
+        const uint32_t capacity = events.size() + 1;
+
+        storage.assign(prismEventBufferSize(encoding, capacity) / sizeof(uint64_t) + 1, 0);
+        times.assign(events.size() + 1, 0);
+        auto buf = reinterpret_cast<EventBuffer*>(storage.data());
+        auto ts = reinterpret_cast<TimestampBuffer*>(times.data());
+        buf->encoding = encoding;
+        buf->capacity = capacity;
+        buf->used = events.size();
+        ts->used = events.size();
+
+        if (encoding == PRISM_EVENTS_COLUMNS)
+            prismColumnsReset(buf);
+
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            ts->timestamps[i] = events[i].time;
+            if (encoding == PRISM_EVENTS_PACKED)
+            {
+                buf->events[i] = events[i].ev;
+                continue;
+            }
+
+            const PrismEvVariant &ev = events[i].ev;
+            prismColumnTags(buf)[i] = ev.tag;
+            if (ev.tag == PRISM_MEM_TAG)
+            {
+                PrismMemSlot &slot = prismColumnMem(buf)[prismColumns(buf)->mem++];
+                slot.begin_addr = ev.mem.begin_addr;
+                slot.size = ev.mem.size;
+                slot.type = ev.mem.type;
+            }
+            else if (ev.tag == PRISM_SYNC_TAG)
+            {
+                PrismSyncSlot &slot = prismColumnSync(buf)[prismColumns(buf)->sync++];
+                slot.type = ev.sync.type;
+                slot.data[0] = ev.sync.data[0];
+                slot.data[1] = ev.sync.data[1];
+            }
+        }
+        buf->used = events.size();
+
+        acquired = true;
+        return EventBufferPtr(buf);
+    }
+
+    auto releaseBuffer(EventBufferPtr buf) -> void override
+    {
+        REQUIRE(acquired == true);
+        REQUIRE(buf.get() == reinterpret_cast<EventBuffer*>(storage.data()));
+        buf.release();
+        acquired = false;
+        ++released;
+    }
+
+    unsigned released{0};
+
+  private:
+    std::vector<std::vector<TestEvent>> buffers;
+    const uint32_t encoding;
+    std::string arena;
+    std::vector<uint64_t> storage;
+    std::vector<uint64_t> times;
+    size_t next{0};
+    bool acquired{false};
+};
+
+
+auto drain(MergedFrontend &merge) -> std::vector<PrismEvVariant>
+{
+    std::vector<PrismEvVariant> events;
+    auto buf = merge.acquireBuffer();
+    while (buf != nullptr)
+    {
+        REQUIRE(buf->encoding == PRISM_EVENTS_PACKED);
+        for (size_t i = 0; i < buf->used; ++i)
+            events.push_back(buf->events[i]);
+        merge.releaseBuffer(std::move(buf));
+        buf = merge.acquireBuffer();
+    }
+    return events;
+}
+
+
+TEST_CASE("streams are merged in timestamp order", "[merge]")
+{
+    std::vector<FrontendPtr> inputs;
+    inputs.emplace_back(new TestFrontend({{memEvent(1, 0x10), memEvent(4, 0x11)},
+                                          {memEvent(5, 0x12), memEvent(9, 0x13)}}));
+    inputs.emplace_back(new TestFrontend({{memEvent(2, 0x20), memEvent(3, 0x21)},
+                                          {},
+                                          {memEvent(6, 0x22), memEvent(7, 0x23)}}));
+    MergedFrontend merge(std::move(inputs));
+
+    auto events = drain(merge);
+
+    /* every switch between streams is marked by a swap to that stream */
+    std::vector<std::pair<EvTag, uint64_t>> expected{
+        {PRISM_SYNC_TAG, 1}, {PRISM_MEM_TAG, 0x10},
+        {PRISM_SYNC_TAG, 2}, {PRISM_MEM_TAG, 0x20}, {PRISM_MEM_TAG, 0x21},
+        {PRISM_SYNC_TAG, 1}, {PRISM_MEM_TAG, 0x11}, {PRISM_MEM_TAG, 0x12},
+        {PRISM_SYNC_TAG, 2}, {PRISM_MEM_TAG, 0x22}, {PRISM_MEM_TAG, 0x23},
+        {PRISM_SYNC_TAG, 1}, {PRISM_MEM_TAG, 0x13},
+    };
+
+    REQUIRE(events.size() == expected.size());
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        REQUIRE(events[i].tag == expected[i].first);
+        if (events[i].tag == PRISM_SYNC_TAG)
+        {
+            REQUIRE(events[i].sync.type == PRISM_SYNC_SWAP);
+            REQUIRE(events[i].sync.data[0] == static_cast<SyncID>(expected[i].second));
+        }
+        else
+        {
+            REQUIRE(events[i].mem.begin_addr == expected[i].second);
+        }
+    }
+}
+
+
+TEST_CASE("equal timestamps keep input order", "[merge]")
+{
+    std::vector<FrontendPtr> inputs;
+    inputs.emplace_back(new TestFrontend({{memEvent(1, 0x10), memEvent(1, 0x11)}}));
+    inputs.emplace_back(new TestFrontend({{memEvent(1, 0x20)}}));
+    MergedFrontend merge(std::move(inputs));
+
+    auto events = drain(merge);
+
+    REQUIRE(events.size() == 5);
+    REQUIRE(events[1].mem.begin_addr == 0x10);
+    REQUIRE(events[2].mem.begin_addr == 0x11);
+    REQUIRE(events[3].tag == PRISM_SYNC_TAG);
+    REQUIRE(events[4].mem.begin_addr == 0x20);
+}
+
+
+TEST_CASE("frontend swaps set the stream's thread", "[merge]")
+{
+    std::vector<FrontendPtr> inputs;
+    inputs.emplace_back(new TestFrontend({{swapEvent(1, 7), memEvent(2, 0x10), memEvent(5, 0x11)}}));
+    inputs.emplace_back(new TestFrontend({{memEvent(3, 0x20)}}, PRISM_EVENTS_COLUMNS));
+    MergedFrontend merge(std::move(inputs));
+
+    auto events = drain(merge);
+
+    /* the frontend's own swap is passed through, not duplicated */
+    REQUIRE(events.size() == 6);
+    REQUIRE(events[0].tag == PRISM_SYNC_TAG);
+    REQUIRE(events[0].sync.data[0] == 7);
+    REQUIRE(events[1].mem.begin_addr == 0x10);
+    REQUIRE(events[2].sync.data[0] == 2);
+    REQUIRE(events[3].mem.begin_addr == 0x20);
+    REQUIRE(events[4].sync.data[0] == 7);
+    REQUIRE(events[5].mem.begin_addr == 0x11);
+}
+
+
+TEST_CASE("names are copied into the merged buffer", "[merge]")
+{
+    TestEvent enter;
+    enter.time = 1;
+    enter.ev.tag = PRISM_CXT_TAG;
+    enter.ev.cxt.type = PRISM_CXT_FUNC_ENTER;
+    enter.ev.cxt.idx = 4;
+    enter.ev.cxt.len = 5;
+
+    std::vector<FrontendPtr> inputs;
+    inputs.emplace_back(new TestFrontend({{enter}}, PRISM_EVENTS_PACKED, std::string("xxx\0main", 9)));
+    MergedFrontend merge(std::move(inputs));
+
+    auto buf = merge.acquireBuffer();
+    REQUIRE(buf != nullptr);
+    REQUIRE(buf->used == 2);
+    const PrismCxtEv &cxt = buf->events[1].cxt;
+    REQUIRE(std::string(merge.nameBase() + cxt.idx) == "main");
+    merge.releaseBuffer(std::move(buf));
+
+    REQUIRE(merge.acquireBuffer() == nullptr);
+}
+
+
+TEST_CASE("merged buffers are bounded", "[merge]")
+{
+    std::vector<std::vector<TestEvent>> a, b;
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        a.push_back({memEvent(2*i, i)});
+        b.push_back({memEvent(2*i + 1, i)});
+    }
+
+    std::vector<FrontendPtr> inputs;
+    inputs.emplace_back(new TestFrontend(std::move(a)));
+    inputs.emplace_back(new TestFrontend(std::move(b)));
+    MergedFrontend merge(std::move(inputs), 16);
+
+    size_t total = 0;
+    auto buf = merge.acquireBuffer();
+    while (buf != nullptr)
+    {
+        REQUIRE(buf->used <= 16);
+        total += buf->used;
+        merge.releaseBuffer(std::move(buf));
+        buf = merge.acquireBuffer();
+    }
+
+    /* every event follows a swap */
+    REQUIRE(total == 400);
+}
@@ -0,0 +1,71 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "Core/Sampling.hpp"
+
+using prism::SampleWindow;
+
+
+auto marker(SampleWindow &window, CxtType type, PtrVal id) -> void
+{
+    PrismCxtEv ev;
+    ev.type = type;
+    ev.id = id;
+    GetNameBase nameBase = []{ return static_cast<const char*>(nullptr); };
+    window.onCxt({ev, nameBase});
+}
+
+
+TEST_CASE("an unsampled stream is not scaled", "[sampling]")
+{
+    SampleWindow window;
+    marker(window, PRISM_CXT_INSTR, 0x400000);
+
+    REQUIRE(window.sampled() == false);
+    REQUIRE(window.scale() == 1.0);
+    REQUIRE(window.extrapolate(42) == 42);
+}
+
+
+TEST_CASE("totals are extrapolated from the traced fraction", "[sampling]")
+{
+    /* period 1000, length 100 */
+    SampleWindow window;
+    for (PtrVal period = 0; period < 4000; period += 1000)
+    {
+        marker(window, PRISM_CXT_SAMPLE_BEGIN, period + 900);
+        marker(window, PRISM_CXT_SAMPLE_END, period + 1000);
+    }
+
+    REQUIRE(window.samples() == 4);
+    REQUIRE(window.sampledInstructions() == 400);
+    REQUIRE(window.elapsedInstructions() == 4000);
+    REQUIRE(window.scale() == Approx(10.0));
+    REQUIRE(window.extrapolate(123) == 1230);
+}
+
+
+TEST_CASE("unmatched markers are ignored", "[sampling]")
+{
+    SampleWindow window;
+    marker(window, PRISM_CXT_SAMPLE_END, 500);
+    REQUIRE(window.sampled() == false);
+
+    marker(window, PRISM_CXT_SAMPLE_BEGIN, 900);
+    REQUIRE(window.sampled() == false);
+}
+
+
+TEST_CASE("windows from several streams merge", "[sampling]")
+{
+    SampleWindow first, second;
+    marker(first, PRISM_CXT_SAMPLE_BEGIN, 900);
+    marker(first, PRISM_CXT_SAMPLE_END, 1000);
+    marker(second, PRISM_CXT_SAMPLE_BEGIN, 1900);
+    marker(second, PRISM_CXT_SAMPLE_END, 2000);
+
+    first.merge(second);
+    REQUIRE(first.samples() == 2);
+    REQUIRE(first.sampledInstructions() == 200);
+    REQUIRE(first.elapsedInstructions() == 2000);
+}
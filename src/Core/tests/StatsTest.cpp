@@ -0,0 +1,128 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Core/Stats.hpp"
+
+using prism::StreamCounters;
+using prism::PipelineStats;
+
+
+auto packedBuffer(std::vector<uint64_t> &storage, uint32_t capacity,
+                  const std::vector<EvTag> &tags) -> EventBuffer*
+{
+    storage.assign(prismEventBufferSize(PRISM_EVENTS_PACKED, capacity) / sizeof(uint64_t) + 1, 0);
+    auto buf = reinterpret_cast<EventBuffer*>(storage.data());
+    buf->encoding = PRISM_EVENTS_PACKED;
+    buf->capacity = capacity;
+    buf->used = tags.size();
+    for (size_t i = 0; i < tags.size(); ++i)
+        buf->events[i].tag = tags[i];
+    return buf;
+}
+
+
+TEST_CASE("events are counted per type", "[stats]")
+{
+    std::vector<uint64_t> storage;
+    StreamCounters counters;
+
+    counters.count(*packedBuffer(storage, 10, {PRISM_MEM_TAG, PRISM_MEM_TAG, PRISM_COMP_TAG,
+                                               PRISM_SYNC_TAG, PRISM_CXT_TAG}));
+
+    REQUIRE(counters.buffers == 1);
+    REQUIRE(counters.events[PRISM_MEM_TAG] == 2);
+    REQUIRE(counters.events[PRISM_COMP_TAG] == 1);
+    REQUIRE(counters.events[PRISM_SYNC_TAG] == 1);
+    REQUIRE(counters.events[PRISM_CXT_TAG] == 1);
+    REQUIRE(counters.events[PRISM_CF_TAG] == 0);
+
+    /* column buffers are counted from their fill counts */
+    storage.assign(prismEventBufferSize(PRISM_EVENTS_COLUMNS, 10) / sizeof(uint64_t) + 1, 0);
+    auto buf = reinterpret_cast<EventBuffer*>(storage.data());
+    buf->encoding = PRISM_EVENTS_COLUMNS;
+    buf->capacity = 10;
+    prismColumnsReset(buf);
+    prismColumns(buf)->mem = 3;
+    prismColumns(buf)->cf = 1;
+    buf->used = 4;
+    counters.count(*buf);
+
+    REQUIRE(counters.buffers == 2);
+    REQUIRE(counters.events[PRISM_MEM_TAG] == 5);
+    REQUIRE(counters.events[PRISM_CF_TAG] == 1);
+}
+
+
+TEST_CASE("buffers are binned by occupancy", "[stats]")
+{
+    std::vector<uint64_t> storage;
+    StreamCounters counters;
+
+    counters.count(*packedBuffer(storage, 10, {}));
+    counters.count(*packedBuffer(storage, 10, std::vector<EvTag>(5, PRISM_MEM_TAG)));
+    counters.count(*packedBuffer(storage, 10, std::vector<EvTag>(10, PRISM_MEM_TAG)));
+
+    REQUIRE(counters.occupancy[0] == 1);
+    REQUIRE(counters.occupancy[5] == 1);
+    REQUIRE(counters.occupancy[StreamCounters::occupancyBuckets - 1] == 1);
+}
+
+
+TEST_CASE("stage time goes to the stage that just ended", "[stats]")
+{
+    StreamCounters counters;
+    prism::StageClock clock(&counters);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    clock.lap(&StreamCounters::flushNs);
+    clock.lap(&StreamCounters::releaseNs);
+
+    REQUIRE(counters.flushNs >= 20000000);
+    REQUIRE(counters.releaseNs < counters.flushNs);
+    REQUIRE(counters.acquireNs == 0);
+
+    /* without counters the clock does nothing */
+    prism::StageClock off(nullptr);
+    off.lap(&StreamCounters::flushNs);
+}
+
+
+TEST_CASE("the summary is written at exit", "[stats]")
+{
+    char path[] = "/tmp/prism-stats-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    prism::StatsConfig config;
+    config.enabled = true;
+    config.interval = 1;
+    config.path = path;
+
+    {
+        PipelineStats stats(config);
+        std::vector<uint64_t> storage;
+        auto counters = stats.stream();
+        counters->count(*packedBuffer(storage, 4, {PRISM_MEM_TAG, PRISM_COMP_TAG}));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    }
+
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    std::remove(path);
+
+    /* one periodic line, then the summary */
+    REQUIRE(lines.size() == 5);
+    REQUIRE(lines[0].find("events/s") != std::string::npos);
+    REQUIRE(lines[1].find("2 events in 1 buffers") != std::string::npos);
+    REQUIRE(lines[3].find("mem 1") != std::string::npos);
+}
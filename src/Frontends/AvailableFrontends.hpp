@@ -4,5 +4,7 @@
 #include "Gengrind/GengrindFrontend.hpp"
 #include "DrSigil/DrSigilFrontend.hpp"
 #include "PerfPT/PerfPTFrontend.hpp"
+#include "Synthetic/SyntheticFrontend.hpp"
+#include "Replay/ReplayFrontend.hpp"
 
 #endif
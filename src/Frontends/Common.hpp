@@ -3,6 +3,8 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <vector>
+#include <cassert>
 
 /* Common Utility classes */ 
 
@@ -39,25 +41,32 @@ class Sem
 };
 
 
-template<typename T, unsigned N>
+template<typename T>
 struct CircularQueue
 {
-    static_assert((N >= 2) && ((N & (N - 1)) == 0), "N must be a power of 2");
+    /* Single producer, single consumer;
+     * the size is fixed at construction */
   public:
+    CircularQueue(size_t n) : q(n), mask(n-1)
+    {
+        assert((n >= 2) && ((n & (n - 1)) == 0) && "n must be a power of 2");
+    }
+
     auto enqueue(T val)
     {
         q[tail] = val;
-        tail = (tail+1) & (N-1);
+        tail = (tail+1) & mask;
     }
 
     auto dequeue()
     {
         auto temp = head;
-        head = (head+1) & (N-1);
+        head = (head+1) & mask;
         return q[temp];
     }
 
-    T q[N];
+    std::vector<T> q;
+    const size_t mask;
     size_t head{0}, tail{0};
 };
 
@@ -8,22 +8,169 @@
 #define PRISM_IPC_FULLFIFO_BASENAME  ("prism-full")
 #define PRISM_IPC_FINISHED (0xFFFFFFFFu)
 #define PRISM_IPC_BUFFERS (8) /* An empirically based fudge number;
-                               * can be tweaked */
+                               * can be tweaked at runtime, see PrismIPCHeader */
+#define PRISM_IPC_MAX_BUFFERS (1024)
+#define PRISM_IPC_MIN_BUFFER_EVENTS (1024)
+/* Gengrind reserves all events for a superblock at once,
+ * so a buffer must hold at least that many */
+#define PRISM_IPC_MAX_BUFFER_EVENTS (1UL << 24)
+#define PRISM_IPC_MAX_CHANNELS (16)
+/* One channel (segment + named pipes) per backend thread */
+
+#define PRISM_IPC_TRANSPORT_FIFO  (0u)
+#define PRISM_IPC_TRANSPORT_FUTEX (1u)
+#define PRISM_IPC_FUTEX_TIMEOUT_NS (100000000L)
+/* How long either side sleeps on a futex before
+ * checking that the other side is still alive */
 
 #ifdef __cplusplus
 static_assert((PRISM_IPC_BUFFERS >= 2) &&
               ((PRISM_IPC_BUFFERS & (PRISM_IPC_BUFFERS - 1)) == 0),
               "PRISM_IPC_BUFFERS must be a power of 2");
+static_assert(PRISM_IPC_BUFFERS <= PRISM_IPC_MAX_BUFFERS &&
+              PRISM_EVENTS_BUFFER_SIZE >= PRISM_IPC_MIN_BUFFER_EVENTS,
+              "default IPC buffer configuration out of range");
 #else
+typedef struct PrismIPCHeader PrismIPCHeader;
 typedef struct PrismDBISharedData PrismDBISharedData;
 typedef struct PrismPerfSharedData PrismPerfSharedData;
 #endif
 
+struct PrismIPCHeader
+{
+    /* Control words at the start of the shared memory segment.
+     * Prism fills in the configuration before the external tool connects.
+     *
+     * With PRISM_IPC_TRANSPORT_FIFO, buffer indices are passed
+     * through the 'full' and 'empty' named pipes, one syscall per buffer
+     * on each side, and the remaining words are unused.
+     *
+     * With PRISM_IPC_TRANSPORT_FUTEX, the buffers form a
+     * single-producer/single-consumer ring:
+     * - 'produced' counts buffers filled by the external tool
+     * - 'consumed' counts buffers released by Prism
+     * Both only ever increase (modulo 2^32), and buffer 'n % bufferCount'
+     * is the n-th buffer in the stream. Each side publishes its counter
+     * with a sequentially consistent store and only issues a FUTEX_WAKE
+     * if the other side has set its 'waiting' flag.
+     * A side that is starved sets its flag, re-checks the counter, and then
+     * sleeps in FUTEX_WAIT on the other side's counter with a timeout.
+     * After each timeout it polls its named pipe for POLLHUP
+     * to detect that the other side has died.
+     * The named pipes are still used to connect and to tear down.
+     *
+     * The number of buffers and their capacities are also chosen at runtime.
+     * The buffers follow the header in the same segment, and each array
+     * starts at the recorded offset, with one buffer every 'stride' bytes.
+     * Use prismIPCEventBuffer() and friends instead of computing addresses.
+     * The buffer count is a power of 2 so the futex counters wrap cleanly.
+     *
+     * 'encoding' is the EventBuffer encoding the external tool must write.
+     * Prism sets 'encoding' and 'capacity' in every EventBuffer up front;
+     * the external tool only resets the used counts.
+     *
+     * Prism opens 'channelCount' channels, one per backend thread, each with
+     * its own segment and named pipes suffixed by 'channel'. They all have
+     * the same configuration. The external tool connects to them in order
+     * and decides which events go to which channel. */
+
+    uint32_t transport;
+    uint32_t encoding;
+    uint32_t bufferCount;
+    uint32_t eventCapacity;
+    uint32_t nameCapacity;
+    uint32_t channel;
+    uint32_t channelCount;
+
+    uint64_t eventBuffersOffset, eventBufferStride;
+    uint64_t timeBuffersOffset, timeBufferStride;
+    uint64_t nameBuffersOffset, nameBufferStride;
+    uint64_t totalSize;
+
+    uint32_t produced;
+    uint32_t consumed;
+    uint32_t finished;
+    uint32_t producerWaiting;
+    uint32_t consumerWaiting;
+};
+
+
+static inline uint64_t prismIPCAlign(uint64_t bytes)
+{
+    /* keep every buffer on its own cache line */
+    return (bytes + 63) & ~(uint64_t)63;
+}
+
+
+static inline uint64_t prismIPCLayout(PrismIPCHeader *header,
+                                      uint32_t bufferCount,
+                                      uint32_t eventCapacity,
+                                      uint32_t nameCapacity,
+                                      uint32_t encoding,
+                                      int withTimestamps)
+{
+    /* Fill in the sizes and offsets of the buffer arrays.
+     * Returns the size of the whole shared segment */
+
+    header->encoding      = encoding;
+    header->bufferCount   = bufferCount;
+    header->eventCapacity = eventCapacity;
+    header->nameCapacity  = nameCapacity;
+
+    uint64_t offset = prismIPCAlign(sizeof(PrismIPCHeader));
+
+    header->eventBuffersOffset = offset;
+    header->eventBufferStride  = prismIPCAlign(prismEventBufferSize(encoding, eventCapacity));
+    offset += header->eventBufferStride * bufferCount;
+
+    header->timeBuffersOffset = 0;
+    header->timeBufferStride  = 0;
+    if (withTimestamps)
+    {
+        header->timeBuffersOffset = offset;
+        header->timeBufferStride  = prismIPCAlign(sizeof(TimestampBuffer) +
+                                                  (uint64_t)eventCapacity * sizeof(uint64_t));
+        offset += header->timeBufferStride * bufferCount;
+    }
+
+    header->nameBuffersOffset = offset;
+    header->nameBufferStride  = prismIPCAlign(sizeof(NameBuffer) + nameCapacity);
+    offset += header->nameBufferStride * bufferCount;
+
+    header->totalSize = offset;
+    return offset;
+}
+
+
+static inline EventBuffer* prismIPCEventBuffer(PrismIPCHeader *header, uint32_t idx)
+{
+    return (EventBuffer*)((char*)header + header->eventBuffersOffset +
+                          idx * header->eventBufferStride);
+}
+
+
+static inline TimestampBuffer* prismIPCTimeBuffer(PrismIPCHeader *header, uint32_t idx)
+{
+    return (TimestampBuffer*)((char*)header + header->timeBuffersOffset +
+                              idx * header->timeBufferStride);
+}
+
+
+static inline NameBuffer* prismIPCNameBuffer(PrismIPCHeader *header, uint32_t idx)
+{
+    return (NameBuffer*)((char*)header + header->nameBuffersOffset +
+                         idx * header->nameBufferStride);
+}
+
+
 struct PrismDBISharedData
 {
-    EventBuffer eventBuffers[PRISM_IPC_BUFFERS];
-    NameBuffer nameBuffers[PRISM_IPC_BUFFERS];
-    /* Each EventBuffer has a corresponding NameBuffer
+    PrismIPCHeader header;
+
+    /* Followed by, as laid out by prismIPCLayout():
+     *   EventBuffer eventBuffers[header.bufferCount];
+     *   NameBuffer nameBuffers[header.bufferCount];
+     * Each EventBuffer has a corresponding NameBuffer
      * as an arena to allocate entity name strings */
 };
 
@@ -52,14 +199,14 @@ struct PrismPerfSharedData
      * intel_pt data would be required to send multiple event streams
      * in parallel from perf to Prism. */
 
-    EventBuffer eventBuffers[PRISM_IPC_BUFFERS];
-
-    TimestampBuffer timeBuffers[PRISM_IPC_BUFFERS];
-    /* Each EventBuffer has a corresponding TimestampBuffer
-     * to order events between threads */
+    PrismIPCHeader header;
 
-    NameBuffer nameBuffers[PRISM_IPC_BUFFERS];
-    /* Each EventBuffer has a corresponding NameBuffer
+    /* Followed by, as laid out by prismIPCLayout():
+     *   EventBuffer eventBuffers[header.bufferCount];
+     *   TimestampBuffer timeBuffers[header.bufferCount];
+     *   NameBuffer nameBuffers[header.bufferCount];
+     * Each EventBuffer has a corresponding TimestampBuffer
+     * to order events between threads, and a corresponding NameBuffer
      * as an arena to allocate entity name strings */
 };
 
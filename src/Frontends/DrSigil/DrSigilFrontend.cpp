@@ -37,13 +37,15 @@ auto drSigilCapabilities() -> prism::capabilities
 };
 
 #ifndef DYNAMORIO_ENABLE
-auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                  IpcConfig ipc)
     -> FrontendIfaceGenerator
 {
     (void)execArgs;
     (void)feArgs;
     (void)threads;
     (void)reqs;
+    (void)ipc;
     PrismLog::fatal("DynamoRIO frontend not available");
 }
 #else
@@ -216,9 +218,12 @@ auto configureIpcDir() -> std::string
 ////////////////////////////////////////////////////////////
 // Interface to Prism core
 ////////////////////////////////////////////////////////////
-auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                  IpcConfig ipc)
     -> FrontendIfaceGenerator
 {
+    if (ipc.isDefault() == false)
+        fatal("DynamoRIO frontend only supports the default IPC transport, encoding and buffer sizes");
     auto ipcDir = configureIpcDir();
     Cleanup::setCleanupDir(ipcDir);
 
@@ -236,7 +241,7 @@ auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilit
     else
         fatal(std::string("sigrind fork failed -- ") + strerror(errno));
 
-    return [=]{ return std::make_unique<ShmemFrontend<PrismDBISharedData>>(ipcDir); };
+    return ShmemFrontend<PrismDBISharedData>::generator(ipcDir, ipc, threads);
 }
 
 #endif
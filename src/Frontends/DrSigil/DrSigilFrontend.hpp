@@ -3,7 +3,8 @@
 
 #include "Core/Frontends.hpp"
 
-auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startDrSigil(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                  IpcConfig ipc)
     -> FrontendIfaceGenerator;
 auto drSigilCapabilities() -> prism::capabilities;
 
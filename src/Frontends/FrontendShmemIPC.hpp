@@ -5,9 +5,17 @@
 #include "Core/Frontends.hpp"
 #include "CommonShmemIPC.h"
 #include "Common.hpp"
+#include "Core/EventCodec.h"
+#include <atomic>
+#include <fstream>
 #include <thread>
+#include <type_traits>
+#include <vector>
 #include <fcntl.h>
+#include <poll.h>
+#include <linux/futex.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -29,12 +37,33 @@
  * Otherwise each process would require less efficient synchronization methods
  * such as spinning.
  *
+ * Alternatively, the 'futex' transport keeps the producer/consumer counters
+ * in the shared memory header and only makes a syscall when one side is
+ * starved. The named pipes then only serve to connect, to detect if the
+ * other side has died, and to tear down.
+ *
+ * With '--ipc-hugepages=on' the segment is a memfd backed by transparent huge
+ * pages (MADV_HUGEPAGE), mapped on a huge page boundary. Tmpfs mounts such as
+ * /dev/shm ignore the system huge page setting unless mounted with 'huge=',
+ * while memfds follow it. The usual shared memory file in the ipc directory
+ * becomes a symlink to the memfd, so the external tool needs no changes.
+ * If huge pages are not available, Prism warns and uses a normal file.
+ *
+ * With '--ipc-encoding=compact' the external tool writes a delta/varint byte
+ * stream (see EventCodec.h), which fits several times more events in the
+ * same segment. Prism decodes each buffer into packed events on acquire,
+ * so backends never see the compact encoding.
+ *
+ * A multi-threaded external tool (or one that splits its event stream) gets
+ * one such channel per backend thread, numbered from 0, see generator().
+ *
  * XXX The term 'full' buffer is for historical reasons. A buffer does not
  * necessarily have to be full when used by Prism. There should be metadata
  * available to let Prism know how many valid events are in the buffer.
  */
 
 
+using PrismLog::info;
 using PrismLog::warn;
 using PrismLog::fatal;
 
@@ -47,6 +76,8 @@ auto setCleanupDir(std::string dir) -> void;
 template <typename SharedData>
 class ShmemFrontend : public FrontendIface
 {
+    const unsigned channel;
+    const unsigned channels;
     const std::string ipcDir;
     const std::string emptyFifoName;
     const std::string fullFifoName;
@@ -55,63 +86,118 @@ class ShmemFrontend : public FrontendIface
     int fullfd;
     FILE *shmemfp;
     SharedData *shmem;
+    size_t shmemSize;
+    bool hugePages{false};
+    const IpcConfig ipc;
 
     /* IPC configuration */
-    CircularQueue<int, PRISM_IPC_BUFFERS> q;
-    Sem filled{0}, emptied{PRISM_IPC_BUFFERS};
+    CircularQueue<int> q;
+    Sem filled, emptied;
     int lastBufferIdx;
     /* Keep track of which buffers are in use/ready */
 
+    uint32_t consumed{0};
+    /* futex transport: buffers released so far */
+
+    std::vector<char> decoded;
+    /* compact encoding: packed events of the last acquired buffer */
+
     std::thread eventLoop;
     /* Asynchronously manage external events */
 
   public:
-    ShmemFrontend(const std::string &ipcDir)
-        : ipcDir       (ipcDir)
-        , emptyFifoName(ipcDir + "/" + PRISM_IPC_EMPTYFIFO_BASENAME + "-" + std::to_string(uid))
-        , fullFifoName (ipcDir + "/" + PRISM_IPC_FULLFIFO_BASENAME  + "-" + std::to_string(uid))
-        , shmemName    (ipcDir + "/" + PRISM_IPC_SHMEM_BASENAME     + "-" + std::to_string(uid))
+    ShmemFrontend(const std::string &ipcDir, const IpcConfig &ipc,
+                  unsigned channel = 0, unsigned channels = 1)
+        : channel      (channel)
+        , channels     (channels)
+        , ipcDir       (ipcDir)
+        , emptyFifoName(ipcDir + "/" + PRISM_IPC_EMPTYFIFO_BASENAME + "-" + std::to_string(channel))
+        , fullFifoName (ipcDir + "/" + PRISM_IPC_FULLFIFO_BASENAME  + "-" + std::to_string(channel))
+        , shmemName    (ipcDir + "/" + PRISM_IPC_SHMEM_BASENAME     + "-" + std::to_string(channel))
+        , ipc          (ipc)
+        , q            (ipc.buffers)
+        , filled       (0)
+        , emptied      (ipc.buffers)
     {
         initShMem();
         emptyfd = createAndOpenNewFifo(emptyFifoName.c_str(), O_WRONLY);
         fullfd = createAndOpenNewFifo(fullFifoName.c_str(), O_RDONLY);
 
         /* asynchronously manage communications with the external tool */
-        eventLoop = std::thread{&ShmemFrontend::receiveEventsLoop, this};
-
-        FrontendIface::nameBase = [&]{ assert(lastBufferIdx < decltype(lastBufferIdx){PRISM_IPC_BUFFERS});
-                                       return shmem->nameBuffers[lastBufferIdx].names; };
+        if (ipc.transport == IpcTransport::fifo)
+            eventLoop = std::thread{&ShmemFrontend::receiveEventsLoop, this};
+
+        FrontendIface::nameBase = [&]{ assert(lastBufferIdx >= 0 && unsigned(lastBufferIdx) < ipc.buffers);
+                                       return prismIPCNameBuffer(&shmem->header, lastBufferIdx)->names; };
+        if (shmem->header.timeBuffersOffset != 0)
+            FrontendIface::timestamps = [&]{ assert(lastBufferIdx >= 0 && unsigned(lastBufferIdx) < ipc.buffers);
+                                             return prismIPCTimeBuffer(&shmem->header, lastBufferIdx); };
     }
 
     ~ShmemFrontend() override
     {
         /* All communication with the external tool
          * should be completed by destruction */
-        eventLoop.join();
+        if (eventLoop.joinable())
+            eventLoop.join();
         disconnect();
     }
 
+    static auto generator(const std::string &ipcDir, const IpcConfig &ipc, unsigned channels)
+        -> FrontendIfaceGenerator
+    {
+        /* Hand out channels 0..channels-1 in the order
+         * the backend threads ask for an interface */
+        assert(channels >= 1 && channels <= PRISM_IPC_MAX_CHANNELS);
+        auto next = std::make_shared<std::atomic<unsigned>>(0);
+        return [=]{ unsigned channel = (*next)++;
+                    assert(channel < channels);
+                    return std::make_unique<ShmemFrontend>(ipcDir, ipc, channel, channels); };
+    }
+
     virtual auto acquireBuffer() -> EventBufferPtr override final
     {
-        filled.P();
-        lastBufferIdx = q.dequeue();
+        if (ipc.transport == IpcTransport::futex)
+        {
+            lastBufferIdx = waitForFullBuffer();
+        }
+        else
+        {
+            filled.P();
+            lastBufferIdx = q.dequeue();
+        }
 
         /* can be negative to signal the end of the event stream */
-        assert(lastBufferIdx < decltype(lastBufferIdx){PRISM_IPC_BUFFERS});
+        assert(lastBufferIdx < 0 || unsigned(lastBufferIdx) < ipc.buffers);
 
         if (lastBufferIdx < 0)
             return nullptr;
-        else
-            return EventBufferPtr(&(shmem->eventBuffers[lastBufferIdx]));
+
+        EventBuffer *buf = prismIPCEventBuffer(&shmem->header, lastBufferIdx);
+        if (ipc.encoding == EventEncoding::compact)
+            buf = decodeCompact(buf);
+        return EventBufferPtr(buf);
     }
 
     virtual auto releaseBuffer(EventBufferPtr eventBuffer) -> void override final
     {
         eventBuffer.release();
+
+        if (ipc.transport == IpcTransport::futex)
+        {
+            /* Publish the release, and only wake the
+             * external tool if it ran out of empty buffers */
+            auto &header = shmem->header;
+            __atomic_store_n(&header.consumed, ++consumed, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&header.producerWaiting, __ATOMIC_SEQ_CST) != 0)
+                futex(&header.consumed, FUTEX_WAKE, 1, nullptr);
+            return;
+        }
+
         emptied.V();
 
         /* Tell Valgrind that the buffer is empty again */
-        assert(lastBufferIdx < decltype(lastBufferIdx){PRISM_IPC_BUFFERS} && lastBufferIdx >= 0);
+        assert(lastBufferIdx >= 0 && unsigned(lastBufferIdx) < ipc.buffers);
         writeEmptyFifo(lastBufferIdx);
     }
 
@@ -121,34 +207,182 @@ class ShmemFrontend : public FrontendIface
     {
         /* Initialize IPC between Prism and the external tool */
 
-        shmemfp = fopen(shmemName.c_str(), "wb+");
+        const size_t hugePageSize = ipc.hugePages ? getHugePageSize() : 0;
+        shmemfp = (hugePageSize > 0) ? openHugePageFile() : nullptr;
+        if (shmemfp == nullptr)
+            shmemfp = fopen(shmemName.c_str(), "wb+");
         if (shmemfp == nullptr)
             fatal(std::string("prism shared memory file open failed -- ") + strerror(errno));
 
-        /* XXX From write(2) man pages:
-         *
-         * On Linux, write() (and similar system calls) will transfer at most
-         * 0x7ffff000 (2,147,479,552) bytes, returning the number of bytes
-         * actually transferred.  (This is true on both 32-bit and 64-bit
-         * systems.)
-         *
-         * fwrite doesn't have this limitation */
-        auto init = std::make_unique<SharedData>();
-        int count = fwrite(init.get(), sizeof(SharedData), 1, shmemfp);
-        if (count != 1)
+        /* The segment size depends on the runtime buffer configuration.
+         * Extending the file zero-fills it, so no buffers need to be written
+         * out; the header is filled in through the mapping */
+        PrismIPCHeader layout = {};
+        const uint32_t encoding = (ipc.encoding == EventEncoding::columns) ?
+                                  PRISM_EVENTS_COLUMNS :
+                                  (ipc.encoding == EventEncoding::compact) ?
+                                  PRISM_EVENTS_COMPACT :
+                                  PRISM_EVENTS_PACKED;
+        shmemSize = prismIPCLayout(&layout, ipc.buffers, ipc.bufferEvents,
+                                   PRISM_NAMES_BUFFER_SIZE, encoding,
+                                   std::is_same<SharedData, PrismPerfSharedData>::value);
+
+        if (hugePages == true)
+            shmemSize = (shmemSize + hugePageSize - 1) & ~(hugePageSize - 1);
+
+        if (ftruncate(fileno(shmemfp), shmemSize) != 0)
         {
             fclose(shmemfp);
             fatal(std::string("prism shared memory file write failed -- ") + strerror(errno));
         }
 
+        void *addr = (hugePages == true) ? reserveAligned(shmemSize, hugePageSize) : nullptr;
         shmem = reinterpret_cast<SharedData *>
-            (mmap(nullptr, sizeof(SharedData), PROT_READ | PROT_WRITE, MAP_SHARED,
+            (mmap(addr, shmemSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | (addr != nullptr ? MAP_FIXED : 0),
                   fileno(shmemfp), 0));
         if (shmem == MAP_FAILED)
         {
             fclose(shmemfp);
             fatal(std::string("prism mmap shared memory failed -- ") + strerror(errno));
         }
+
+        if (hugePages == true)
+            adviseHugePages(hugePageSize);
+
+        shmem->header = layout;
+        shmem->header.channel = channel;
+        shmem->header.channelCount = channels;
+        shmem->header.transport = (ipc.transport == IpcTransport::futex) ?
+                                  PRISM_IPC_TRANSPORT_FUTEX :
+                                  PRISM_IPC_TRANSPORT_FIFO;
+
+        for (unsigned i = 0; i < ipc.buffers; ++i)
+        {
+            EventBuffer *buf = prismIPCEventBuffer(&shmem->header, i);
+            buf->encoding = encoding;
+            buf->capacity = ipc.bufferEvents;
+        }
+    }
+
+    auto decodeCompact(const EventBuffer *buf) -> EventBuffer*
+    {
+        /* The shared memory buffer itself is left alone,
+         * so it can be released as usual */
+        if (buf->encoding != PRISM_EVENTS_COMPACT)
+            fatal("prism expected a compact event buffer from the external tool");
+
+        /* every event takes at least one byte */
+        if (buf->used > prismCompactCapacity(buf))
+            fatal("prism received a corrupt compact event buffer");
+
+        decoded.resize(prismEventBufferSize(PRISM_EVENTS_PACKED, buf->used));
+        auto packed = reinterpret_cast<EventBuffer*>(decoded.data());
+        if (prismDecodeCompact(buf, packed) == 0)
+            fatal("prism received a corrupt compact event buffer");
+
+        return packed;
+    }
+
+    auto openHugePageFile() -> FILE*
+    {
+        /* Returns nullptr if Prism should fall back to a normal file */
+
+        auto name = std::string(PRISM_IPC_SHMEM_BASENAME) + "-" + std::to_string(channel);
+        int fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            warn(std::string("prism could not create a memfd for IPC, "
+                             "using normal pages -- ") + strerror(errno));
+            return nullptr;
+        }
+
+        /* The external tool opens the memfd through this process */
+        auto target = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd);
+        if ((remove(shmemName.c_str()) != 0 && errno != ENOENT) ||
+            symlink(target.c_str(), shmemName.c_str()) != 0)
+        {
+            warn(std::string("prism could not link the IPC memfd, "
+                             "using normal pages -- ") + strerror(errno));
+            close(fd);
+            return nullptr;
+        }
+
+        FILE *fp = fdopen(fd, "w+");
+        if (fp == nullptr)
+            fatal(std::string("prism shared memory file open failed -- ") + strerror(errno));
+
+        hugePages = true;
+        return fp;
+    }
+
+    static auto getHugePageSize() -> size_t
+    {
+        /* Returns 0 if the kernel cannot back
+         * shared memory with transparent huge pages */
+
+        std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+        std::string setting;
+        if (!std::getline(enabled, setting) ||
+            setting.find("[never]") != std::string::npos ||
+            setting.find("[deny]") != std::string::npos)
+        {
+            warn("transparent huge pages are disabled for shared memory, "
+                 "using normal pages for IPC");
+            return 0;
+        }
+
+        size_t size = 0;
+        std::ifstream pmdSize("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+        if (!(pmdSize >> size) || size == 0 || (size & (size - 1)) != 0)
+        {
+            warn("could not read the huge page size, using normal pages for IPC");
+            return 0;
+        }
+
+        return size;
+    }
+
+    static auto reserveAligned(size_t size, size_t alignment) -> void*
+    {
+        /* A huge page can only map the segment if the virtual
+         * address is aligned to the huge page size as well.
+         * Over-reserve, then trim to an aligned range that the
+         * shared mapping replaces. Returns nullptr on failure,
+         * letting the kernel choose the address */
+
+        void *reserved = mmap(nullptr, size + alignment, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (reserved == MAP_FAILED)
+            return nullptr;
+
+        auto start = reinterpret_cast<uintptr_t>(reserved);
+        auto aligned = (start + alignment - 1) & ~(alignment - 1);
+        if (aligned > start)
+            munmap(reserved, aligned - start);
+        munmap(reinterpret_cast<void*>(aligned + size), start + alignment - aligned);
+
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    auto adviseHugePages(size_t hugePageSize) -> void
+    {
+        if (madvise(shmem, shmemSize, MADV_HUGEPAGE) != 0)
+        {
+            warn(std::string("prism could not advise huge pages for IPC, "
+                             "using normal pages -- ") + strerror(errno));
+            return;
+        }
+
+        /* Fault in the segment now, while the advice applies,
+         * so that the page cache is populated with huge pages
+         * before the external tool maps the file */
+        auto base = reinterpret_cast<volatile char*>(shmem);
+        for (size_t offset = 0; offset < shmemSize; offset += hugePageSize)
+            base[offset] = 0;
+
+        info("IPC shared memory: " + std::to_string(shmemSize / hugePageSize) +
+             " huge pages of " + std::to_string(hugePageSize >> 10) + " KiB");
     }
 
     auto createAndOpenNewFifo(const char *path, int flags) const -> int
@@ -176,7 +410,7 @@ class ShmemFrontend : public FrontendIface
 
     auto disconnect() -> void
     {
-        munmap(shmem, sizeof(SharedData));
+        munmap(shmem, shmemSize);
         fclose(shmemfp);
         close(emptyfd);
         close(fullfd);
@@ -212,6 +446,55 @@ class ShmemFrontend : public FrontendIface
             fatal(std::string("could not send empty buffer status -- ") + strerror(errno));
     }
 
+    static auto futex(uint32_t *addr, int op, uint32_t val,
+                      const struct timespec *timeout) -> long
+    {
+        /* Not FUTEX_PRIVATE: the words are shared with another process */
+        return syscall(SYS_futex, addr, op, val, timeout, nullptr, 0);
+    }
+
+    auto waitForFullBuffer() -> int
+    {
+        /* Returns the index of the next full buffer,
+         * or -1 if the external tool has finished */
+
+        auto &header = shmem->header;
+        const struct timespec timeout = {0, PRISM_IPC_FUTEX_TIMEOUT_NS};
+
+        while (true)
+        {
+            /* 'finished' is set after the last buffer is produced,
+             * so load it first */
+            auto finished = __atomic_load_n(&header.finished, __ATOMIC_ACQUIRE);
+            auto produced = __atomic_load_n(&header.produced, __ATOMIC_ACQUIRE);
+            if (produced != consumed)
+                return consumed % ipc.buffers;
+            else if (finished != 0)
+                return -1;
+
+            __atomic_store_n(&header.consumerWaiting, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&header.produced, __ATOMIC_SEQ_CST) == consumed &&
+                __atomic_load_n(&header.finished, __ATOMIC_SEQ_CST) == 0)
+            {
+                if (futex(&header.produced, FUTEX_WAIT, consumed, &timeout) < 0 &&
+                    errno == ETIMEDOUT)
+                    checkToolAlive();
+            }
+            __atomic_store_n(&header.consumerWaiting, 0, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    auto checkToolAlive() -> void
+    {
+        /* The external tool keeps its end of the 'full' fifo
+         * open until Prism disconnects */
+        struct pollfd pfd = {fullfd, POLLIN, 0};
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLHUP) &&
+            __atomic_load_n(&shmem->header.finished, __ATOMIC_SEQ_CST) == 0 &&
+            __atomic_load_n(&shmem->header.produced, __ATOMIC_SEQ_CST) == consumed)
+            fatal("external tool disconnected before finishing the event stream");
+    }
+
     auto receiveEventsLoop() -> void
     {
         /* main event loop for managing the event buffers */
@@ -229,8 +512,7 @@ class ShmemFrontend : public FrontendIface
             }
             else
             {
-                assert(fromTool < decltype(fromTool){PRISM_IPC_BUFFERS} &&
-                       fromTool >= 0);
+                assert(fromTool < ipc.buffers);
                 q.enqueue(fromTool);
                 filled.V();
             }
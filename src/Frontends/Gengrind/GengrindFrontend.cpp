@@ -19,7 +19,7 @@ auto gengrindCapabilities() -> prism::capabilities
 
     caps[COMPUTE]              = availability::enabled;
     caps[COMPUTE_INT_OR_FLOAT] = availability::enabled;
-    caps[COMPUTE_ARITY]        = availability::nil;
+    caps[COMPUTE_ARITY]        = availability::enabled;
     caps[COMPUTE_OP]           = availability::nil;
     caps[COMPUTE_SIZE]         = availability::nil;
 
@@ -163,8 +163,8 @@ auto vgOpts(const std::vector<std::string> &userExec,
 
     opts += " --ipc-dir=" + ipcDir;
 
-    /* MDL20170720
-     * TODO the Valgrind frontend only has macro granularity support */
+    /* Event types, and then the fields within each type.
+     * Fields the backend does not need are never instrumented */
     reqs[MEMORY] == availability::enabled ?
         opts += " --gen-mem=yes" :
         opts += " --gen-mem=no";
@@ -185,6 +185,15 @@ auto vgOpts(const std::vector<std::string> &userExec,
         opts += " --gen-fn=no";
     opts += " --gen-cf=no";
 
+    auto field = [&](const char *opt, unsigned cap)
+        { opts += std::string(" ") + opt + (reqs[cap] == availability::enabled ? "=yes" : "=no"); };
+    field("--gen-mem-ldst",   MEMORY_LDST);
+    field("--gen-mem-size",   MEMORY_SIZE);
+    field("--gen-mem-addr",   MEMORY_ADDRESS);
+    field("--gen-comp-type",  COMPUTE_INT_OR_FLOAT);
+    field("--gen-comp-arity", COMPUTE_ARITY);
+    field("--gen-sync-args",  SYNC_ARGS);
+
     /* command line arguments will override capabilities */
     for (auto &arg : args)
         opts += " " + arg;
@@ -255,11 +264,15 @@ auto configureIpcDir() -> std::string
 ////////////////////////////////////////////////////////////
 // Interface to Prism core
 ////////////////////////////////////////////////////////////
-auto startGengrind(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startGengrind(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                   IpcConfig ipc)
     -> FrontendIfaceGenerator
 {
-    if (threads != 1)
-        fatal("Valgrind frontend attempted with other than 1 thread");
+    /* Valgrind serializes the guest threads, but Sigrind routes each
+     * guest thread's events to one of 'threads' channels, so that many
+     * backend threads can consume them. See SGL_(ipc_switch_thread) */
+    if (threads < 1 || threads > PRISM_IPC_MAX_CHANNELS)
+        fatal("Valgrind frontend attempted with an invalid number of threads");
     gccWarn(execArgs);
     auto ipcDir = configureIpcDir();
     Cleanup::setCleanupDir(ipcDir);
@@ -289,5 +302,5 @@ auto startGengrind(Args execArgs, Args feArgs, unsigned threads, prism::capabili
     else
         fatal(std::string("sigrind fork failed -- ") + strerror(errno));
 
-    return [=]{ return std::make_unique<ShmemFrontend<PrismDBISharedData>>(ipcDir); };
+    return ShmemFrontend<PrismDBISharedData>::generator(ipcDir, ipc, threads);
 }
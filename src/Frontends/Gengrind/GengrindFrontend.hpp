@@ -3,7 +3,8 @@
 
 #include "Core/Frontends.hpp"
 
-auto startGengrind(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startGengrind(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                   IpcConfig ipc)
     -> FrontendIfaceGenerator;
 auto gengrindCapabilities() -> prism::capabilities;
 
@@ -1,6 +1,7 @@
 #include "gn_bb.h"
 #include "gn_fn.h"
 #include "gn_clo.h"
+#include "gn_events.h"
 #include "gn_debug.h"
 
 
@@ -154,6 +155,10 @@ Int GN_(initBBState)(BBState *bbState, IRSB *obb, IRType hWordTy)
 
     // Any extra state needed
     bbState->jmpsPassed = 0;
+    bbState->segInstrs = 0;
+    bbState->segIops = 0;
+    bbState->segFlops = 0;
+    bbState->filtered = False;
     if (GN_(clo).bbinfo_needed == True) {
         const IRStmt *st = obb->stmts[i];
         Addr origAddr = st->Ist.IMark.addr + st->Ist.IMark.delta;
@@ -168,6 +173,46 @@ Int GN_(initBBState)(BBState *bbState, IRSB *obb, IRType hWordTy)
 }
 
 
+void GN_(countBBOp)(BBState *bbState, const IRStmt *st)
+{
+    /* Same classification as compute events */
+    IRType type = typeOfIRExpr(bbState->nbb->tyenv, st->Ist.WrTmp.data);
+    if (type > Ity_INVALID && type < Ity_F16)
+        bbState->segIops++;
+    else if (type >= Ity_F16 && type < Ity_V128)
+        bbState->segFlops++;
+}
+
+
+void GN_(addEvent_BBSegment)(BBState *bbState)
+{
+    /* One event for the instructions since the last flush (a superblock
+     * is split at each side exit), so a block that exits early only
+     * counts what it executed. The counts are static, and packed into
+     * the event at translation time; see prismPackBB.
+     *
+     * The event goes first, ahead of the segment's other events */
+
+    if (bbState->segInstrs == 0)
+        return;
+
+    GN_ASSERT(bbState->eventsToFlush < GN_MAX_EVENTS_PER_BB);
+    VG_(memmove)(GN_(EvBuffer) + 1, GN_(EvBuffer),
+                 bbState->eventsToFlush * sizeof(GN_(EvVariant)));
+
+    GN_(EvVariant) *ev = GN_(EvBuffer);
+    ev->tag = GN_INSTR_EV;
+    ev->instr.type = PRISM_CXT_BB;
+    ev->instr.id = prismPackBB(bbState->bbInfo->uid, bbState->segInstrs,
+                               bbState->segIops, bbState->segFlops);
+    bbState->eventsToFlush++;
+
+    bbState->segInstrs = 0;
+    bbState->segIops = 0;
+    bbState->segFlops = 0;
+}
+
+
 void GN_(initAllBBsTable)()
 {
     /* Once again, taken from Callgrind */
@@ -31,6 +31,15 @@ struct _BBState {
     // Events are held in a separate global array
 
     Int jmpsPassed;
+
+    UInt segInstrs;
+    UInt segIops;
+    UInt segFlops;
+    // Static counts since the last flush, for basic block events
+
+    Bool filtered;
+    // The block belongs to a function excluded from collection;
+    // it is translated without events
 };
 
 
@@ -88,4 +97,7 @@ void GN_(initAllBBsTable)(void);
 BBInfo* GN_(getBBInfo)(Addr addr);
 Int GN_(initBBState)(BBState *bbState, IRSB *origBB, IRType hWordTy);
 
+void GN_(countBBOp)(BBState *bbState, const IRStmt *st);
+void GN_(addEvent_BBSegment)(BBState *bbState);
+
 #endif
@@ -5,6 +5,7 @@ GN_(CommandLineOptions) GN_(clo);
 void GN_(setCloDefaults)(void)
 {
     GN_(clo).enable_instrumentation = True;
+    GN_(clo).instr_atstart          = True;
     GN_(clo).standalone_test        = False;
     GN_(clo).ipc_dir                = NULL;
     GN_(clo).collect_func           = NULL;
@@ -18,6 +19,21 @@ void GN_(setCloDefaults)(void)
     GN_(clo).gen_bb                 = False;
     GN_(clo).gen_fn                 = False;
     GN_(clo).gen_thr                = False;
+    GN_(clo).gen_mem_ldst           = True;
+    GN_(clo).gen_mem_size           = True;
+    GN_(clo).gen_mem_addr           = True;
+    GN_(clo).gen_comp_type          = True;
+    GN_(clo).gen_comp_arity         = False;
+    GN_(clo).gen_sync_args          = True;
+    GN_(clo).gen_comp_batch         = True;
+    GN_(clo).sample_period          = 0;
+    GN_(clo).sample_length          = 0;
+    GN_(clo).sample_retranslate     = True;
+    GN_(clo).include_fn.count       = 0;
+    GN_(clo).exclude_fn.count       = 0;
+    GN_(clo).include_obj.count      = 0;
+    GN_(clo).exclude_obj.count      = 0;
+    GN_(clo).filter_fns             = False;
     GN_(clo).skip_plt               = True;
     GN_(clo).bbinfo_needed          = False;
 #if GN_ENABLE_DEBUG
@@ -25,8 +41,20 @@ void GN_(setCloDefaults)(void)
 #endif
 }
 
+static void addFilter(GN_(FilterList) *list, const HChar *option, const HChar *pattern)
+{
+    if (list->count == GN_MAX_FILTER_PATTERNS)
+        VG_(fmsg_bad_option)(option, "too many patterns (max %d)\n",
+                             GN_MAX_FILTER_PATTERNS);
+
+    list->patterns[list->count++] = pattern;
+    GN_(clo).filter_fns = True;
+}
+
 Bool GN_(processCmdLineOption)(const HChar* arg)
 {
+    const HChar *pattern;
+
     if      VG_STR_CLO(arg,  "--ipc-dir",    GN_(clo).ipc_dir) {}
     else if VG_STR_CLO(arg,  "--at-func",    GN_(clo).collect_func) {}
     else if VG_STR_CLO(arg,  "--start-func", GN_(clo).start_collect_func) {}
@@ -38,7 +66,22 @@ Bool GN_(processCmdLineOption)(const HChar* arg)
     else if VG_BOOL_CLO(arg, "--gen-fn",     GN_(clo).gen_fn) {}
     else if VG_BOOL_CLO(arg, "--gen-cf",     GN_(clo).gen_cf) {}
     else if VG_BOOL_CLO(arg, "--gen-bb",     GN_(clo).gen_bb) {}
+    else if VG_BOOL_CLO(arg, "--gen-mem-ldst",   GN_(clo).gen_mem_ldst) {}
+    else if VG_BOOL_CLO(arg, "--gen-mem-size",   GN_(clo).gen_mem_size) {}
+    else if VG_BOOL_CLO(arg, "--gen-mem-addr",   GN_(clo).gen_mem_addr) {}
+    else if VG_BOOL_CLO(arg, "--gen-comp-type",  GN_(clo).gen_comp_type) {}
+    else if VG_BOOL_CLO(arg, "--gen-comp-arity", GN_(clo).gen_comp_arity) {}
+    else if VG_BOOL_CLO(arg, "--gen-sync-args",  GN_(clo).gen_sync_args) {}
+    else if VG_BOOL_CLO(arg, "--gen-comp-batch", GN_(clo).gen_comp_batch) {}
     else if VG_BOOL_CLO(arg, "--enable",     GN_(clo).enable_instrumentation) {}
+    else if VG_BOOL_CLO(arg, "--instr-atstart", GN_(clo).instr_atstart) {}
+    else if VG_INT_CLO(arg,  "--sample-period", GN_(clo).sample_period) {}
+    else if VG_INT_CLO(arg,  "--sample-length", GN_(clo).sample_length) {}
+    else if VG_BOOL_CLO(arg, "--sample-retranslate", GN_(clo).sample_retranslate) {}
+    else if VG_STR_CLO(arg,  "--include-fn",  pattern) addFilter(&GN_(clo).include_fn,  "--include-fn",  pattern);
+    else if VG_STR_CLO(arg,  "--exclude-fn",  pattern) addFilter(&GN_(clo).exclude_fn,  "--exclude-fn",  pattern);
+    else if VG_STR_CLO(arg,  "--include-obj", pattern) addFilter(&GN_(clo).include_obj, "--include-obj", pattern);
+    else if VG_STR_CLO(arg,  "--exclude-obj", pattern) addFilter(&GN_(clo).exclude_obj, "--exclude-obj", pattern);
     else if VG_BOOL_CLO(arg, "--test",       GN_(clo).standalone_test) {}
 #if GN_ENABLE_DEBUG
     else if VG_INT_CLO(arg, "--verbose",     GN_(clo).verbose) {}
@@ -3,12 +3,21 @@
 
 #include "gn.h"
 
+#define GN_MAX_FILTER_PATTERNS 32
+
+typedef struct {
+  const HChar* patterns[GN_MAX_FILTER_PATTERNS];
+  UInt count;
+} GN_(FilterList);
+/* glob patterns, see VG_(string_match) */
+
 typedef struct {
   const HChar* ipc_dir;
   const HChar* collect_func;
   const HChar* start_collect_func;
   const HChar* stop_collect_func;
   Bool enable_instrumentation;
+  Bool instr_atstart;
   Bool standalone_test;
   Bool gen_mem;
   Bool gen_comp;
@@ -19,6 +28,33 @@ typedef struct {
   Bool gen_fn;
   Bool gen_thr;
 
+  Bool gen_mem_ldst;
+  Bool gen_mem_size;
+  Bool gen_mem_addr;
+  Bool gen_comp_type;
+  Bool gen_comp_arity;
+  Bool gen_sync_args;
+  /* per-field filters within the event types above;
+   * a disabled field is not instrumented and its value is undefined */
+
+  Bool gen_comp_batch;
+  /* one event per run of compute ops; off if arity is generated,
+   * which is only when asked for */
+
+  Long sample_period;
+  Long sample_length;
+  Bool sample_retranslate;
+  /* trace the last 'length' of every 'period' guest instructions;
+   * a period of 0 traces every instruction */
+
+  GN_(FilterList) include_fn;
+  GN_(FilterList) exclude_fn;
+  GN_(FilterList) include_obj;
+  GN_(FilterList) exclude_obj;
+  Bool filter_fns;
+  /* functions are collected if they match every non-empty include list,
+   * and no exclude list; set if any list is non-empty */
+
   Bool skip_plt;
 
   Bool bbinfo_needed;
@@ -12,11 +12,20 @@ Bool GN_(handleClientRequest)(ThreadId tid, UWord *args, UWord *ret)
 
     switch(args[0]) 
     {
+    /*******************************************
+     * Region of interest
+     *******************************************/
     case VG_USERREQ__TOGGLE_COLLECT:
+        GN_(setInstrumentState)("Client Request: toggle",
+                                GN_(InstrumentationOn) == False);
+        *ret = 0; // meaningless
+        break;
     case VG_USERREQ__START_INSTRUMENTATION:
+        GN_(setInstrumentState)("Client Request", True);
+        *ret = 0; // meaningless
+        break;
     case VG_USERREQ__STOP_INSTRUMENTATION:
-        /* unimplemented */
-        GN_ASSERT(False);
+        GN_(setInstrumentState)("Client Request", False);
         *ret = 0; // meaningless
         break;
 
@@ -68,16 +68,20 @@ typedef
    } Vg_GengrindClientRequest;
 
 
-/* For future use */
+/*----------------------------*/
+/*---  Region of interest  ---*/
+/*----------------------------*/
+/* Toggle event generation; see --instr-atstart.
+ * A context marker is emitted at each boundary. */
 #define CALLGRIND_TOGGLE_COLLECT                                \
   VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__TOGGLE_COLLECT,   \
                                   0, 0, 0, 0, 0)
-/* For future use */
+/* Begin the region of interest */
 #define CALLGRIND_START_INSTRUMENTATION                              \
   VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__START_INSTRUMENTATION, \
                                   0, 0, 0, 0, 0)
 
-/* For future use */
+/* End the region of interest and flush the partial buffer */
 #define CALLGRIND_STOP_INSTRUMENTATION                               \
   VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__STOP_INSTRUMENTATION,  \
                                   0, 0, 0, 0, 0)
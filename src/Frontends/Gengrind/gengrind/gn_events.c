@@ -1,10 +1,12 @@
 #include "gn.h"
 #include "gn_events.h"
+#include "pub_tool_transtab.h"
 #include "gn_ipc.h"
 #include "gn_clo.h"
 #include "gn_callstack.h"
 #include "gn_threads.h"
 #include "gn_bb.h"
+#include "gn_sample.h"
 #include "gn_debug.h"
 
 #define UNUSED_SYNC_DATA 0
@@ -18,6 +20,8 @@
  */
 
 Bool GN_(EventGenerationEnabled);
+Bool GN_(InstrumentationOn);
+static PtrVal roiCount = 0;
 
 //-------------------------------------------------------------------------------------------------
 /** Global BB event tracking definitions **/
@@ -61,6 +65,7 @@ void GN_(addEvent_Instr)(BBState *bbState, const IRStmt *st)
     GN_DEBUG(6, "+ addEvent_Instr\n");
 
     GN_ASSERT(st->tag == Ist_IMark);
+    bbState->segInstrs++;
     if (GN_(clo).gen_instr == False)
         return;
 
@@ -94,14 +99,65 @@ void GN_(addEvent_Instr)(BBState *bbState, const IRStmt *st)
 }
 
 
+static void addEvent_ComputeBatch(BBState *bbState, const IRStmt *st)
+{
+    /* Consecutive compute ops are folded into the last queued event,
+     * if it is a batch with room; any other event ends the run.
+     * The counts are static, so the batch costs one event at run time */
+
+    GN_(EvVariant) *ev = NULL;
+    if (bbState->eventsToFlush > 0) {
+        ev = GN_(EvBuffer) + bbState->eventsToFlush - 1;
+        if (ev->tag != GN_COMPUTE_EV ||
+                ev->comp.iops == 0xff || ev->comp.flops == 0xff || ev->comp.otherOps == 0xff)
+            ev = NULL;
+    }
+
+    if (ev == NULL) {
+        GN_ASSERT(bbState->eventsToFlush < GN_MAX_EVENTS_PER_BB);
+        ev = GN_(EvBuffer) + bbState->eventsToFlush;
+        ev->tag = GN_COMPUTE_EV;
+        ev->comp.type = PRISM_COMP_BATCH;
+        ev->comp.iops = 0;
+        ev->comp.flops = 0;
+        ev->comp.otherOps = 0;
+        bbState->eventsToFlush++;
+    }
+
+    /* same classification as single compute events */
+    IRType type = typeOfIRExpr(bbState->nbb->tyenv, st->Ist.WrTmp.data);
+    if (type > Ity_INVALID && type < Ity_F16)
+        ev->comp.iops++;
+    else if (type >= Ity_F16 && type < Ity_V128)
+        ev->comp.flops++;
+    else
+        ev->comp.otherOps++;
+
+    GN_DEBUGIF(4) {
+        GN_(printTabs)(1);
+        VG_(printf)("Batched Event: Compute - ");
+        VG_(printf)("iops: %u flops: %u other: %u", ev->comp.iops,
+                    ev->comp.flops, ev->comp.otherOps);
+        VG_(printf)("\n");
+    }
+}
+
+
 void GN_(addEvent_Compute)(BBState *bbState, const IRStmt *st)
 {
     GN_DEBUG(6, "+ addEvent_Compute\n");
 
     GN_ASSERT(st->tag == Ist_WrTmp);
+    if (GN_(clo).gen_bb == True)
+        GN_(countBBOp)(bbState, st);
     if (GN_(clo).gen_comp == False)
         return;
 
+    if (GN_(clo).gen_comp_batch == True) {
+        addEvent_ComputeBatch(bbState, st);
+        return;
+    }
+
     GN_ASSERT(bbState->eventsToFlush < GN_MAX_EVENTS_PER_BB);
     GN_(EvVariant) *ev = GN_(EvBuffer) + bbState->eventsToFlush;
 
@@ -115,7 +171,7 @@ void GN_(addEvent_Compute)(BBState *bbState, const IRStmt *st)
     IRType type = typeOfIRExpr(bbState->nbb->tyenv, data);
     IRExprTag arity = data->tag;
 
-    if (type > Ity_INVALID) {
+    if (GN_(clo).gen_comp_type == True && type > Ity_INVALID) {
         if (type < Ity_F16) {
             ev->comp.type = PRISM_COMP_IOP;
         }
@@ -129,22 +185,24 @@ void GN_(addEvent_Compute)(BBState *bbState, const IRStmt *st)
         }
     }
 
-    switch (arity) {
-    case Iex_Unop:
-        ev->comp.arity = PRISM_COMP_UNARY;
-        break;
-    case Iex_Binop:
-        ev->comp.arity = PRISM_COMP_BINARY;
-        break;
-    case Iex_Triop:
-        ev->comp.arity = PRISM_COMP_TERNARY;
-        break;
-    case Iex_Qop:
-        ev->comp.arity = PRISM_COMP_QUARTERNARY;
-        break;
-    default:
-        tl_assert(0);
-        break;
+    if (GN_(clo).gen_comp_arity == True) {
+        switch (arity) {
+        case Iex_Unop:
+            ev->comp.arity = PRISM_COMP_UNARY;
+            break;
+        case Iex_Binop:
+            ev->comp.arity = PRISM_COMP_BINARY;
+            break;
+        case Iex_Triop:
+            ev->comp.arity = PRISM_COMP_TERNARY;
+            break;
+        case Iex_Qop:
+            ev->comp.arity = PRISM_COMP_QUARTERNARY;
+            break;
+        default:
+            tl_assert(0);
+            break;
+        }
     }
 
     /* TODO op mappings  */
@@ -606,10 +664,10 @@ static IRTemp gnInstrumentEvent_Instr(IRSB *bb, GN_(InstrEvent) *ev,
     /* slot.tag <- instr tag */
     GN_STORE_CONST_TO_OFFSET(bb, slot, PRISM_CXT_TAG, PrismEvVariant, tag);
 
-    /* slot.cxt.type <- instr */
-    GN_STORE_CONST_TO_OFFSET(bb, slot, PRISM_CXT_INSTR, PrismEvVariant, cxt.type);
+    /* slot.cxt.type <- instr/bb */
+    GN_STORE_CONST_TO_OFFSET(bb, slot, ev->type, PrismEvVariant, cxt.type);
 
-    /* slot.cxt.id <- iaddr */
+    /* slot.cxt.id <- iaddr, or the packed block counts */
     GN_STORE_CONST_TO_OFFSET(bb, slot, ev->id, PrismEvVariant, cxt.id);
 
     return incrSlot(bb, slot, slotSize, tyW);
@@ -622,11 +680,22 @@ static IRTemp gnInstrumentEvent_Compute(IRSB *bb, GN_(ComputeEvent) *ev,
     /* slot.tag <- comp tag */
     GN_STORE_CONST_TO_OFFSET(bb, slot, PRISM_COMP_TAG, PrismEvVariant, tag);
 
+    /* slot.comp.{type,iops,flops,otherOps} <- batch counts */
+    if (ev->type == PRISM_COMP_BATCH) {
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->type, PrismEvVariant, comp.type);
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->iops, PrismEvVariant, comp.iops);
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->flops, PrismEvVariant, comp.flops);
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->otherOps, PrismEvVariant, comp.otherOps);
+        return incrSlot(bb, slot, slotSize, tyW);
+    }
+
     /* slot.comp.type <- iop/flop/simd */
-    GN_STORE_CONST_TO_OFFSET(bb, slot, ev->type, PrismEvVariant, comp.type);
+    if (GN_(clo).gen_comp_type == True)
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->type, PrismEvVariant, comp.type);
 
     /* slot.comp.arity <- comp arity */
-    GN_STORE_CONST_TO_OFFSET(bb, slot, ev->arity, PrismEvVariant, comp.arity);
+    if (GN_(clo).gen_comp_arity == True)
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->arity, PrismEvVariant, comp.arity);
 
     return incrSlot(bb, slot, slotSize, tyW);
 }
@@ -638,15 +707,21 @@ static IRTemp gnInstrumentEvent_Memory(IRSB *bb, GN_(MemoryEvent) *ev,
     /* slot.tag <- mem tag */
     GN_STORE_CONST_TO_OFFSET(bb, slot, PRISM_MEM_TAG, PrismEvVariant, tag);
 
+    /* Only the fields the backend asked for are stored;
+     * SimpleCount, for instance, only needs the tag and type */
+
     /* slot.mem.type <- load/store */
-    GN_STORE_CONST_TO_OFFSET(bb, slot, ev->load ? PRISM_MEM_LOAD : PRISM_MEM_STORE,
-                             PrismEvVariant, mem.type);
+    if (GN_(clo).gen_mem_ldst == True)
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->load ? PRISM_MEM_LOAD : PRISM_MEM_STORE,
+                                 PrismEvVariant, mem.type);
 
     /* slot.mem.size <- access size */
-    GN_STORE_CONST_TO_OFFSET(bb, slot, ev->size, PrismEvVariant, mem.size);
+    if (GN_(clo).gen_mem_size == True)
+        GN_STORE_CONST_TO_OFFSET(bb, slot, ev->size, PrismEvVariant, mem.size);
 
     /* slot.mem.addr <- aexpr */
-    GN_STORE_EXPR_TO_OFFSET(bb, slot, ev->aexpr, PrismEvVariant, mem.begin_addr);
+    if (GN_(clo).gen_mem_addr == True)
+        GN_STORE_EXPR_TO_OFFSET(bb, slot, ev->aexpr, PrismEvVariant, mem.begin_addr);
 
     IRTemp newSlot;
 
@@ -680,7 +755,13 @@ static void gnInstrument_JmpsPassed(IRSB *bb, Int jmp)
 
 static void gnInstrument_skipIfEventGenDisabled(IRSB *bb, IRConst *dst, IRJumpKind ijk)
 {
+    /* With function tracking, blocks stay instrumented outside the
+     * region of interest, so they need the check as well.
+     * Fast-forward translations have no check at all, but the block
+     * that ends a sample still runs its sampled version once */
     if (!(GN_(clo).gen_sync == True ||
+          GN_(clo).gen_fn == True ||
+          GN_(clo).sample_period > 0 ||
           GN_(clo).start_collect_func != NULL ||
           GN_(clo).stop_collect_func != NULL))
         return;
@@ -853,10 +934,15 @@ void GN_(flushEvents)(BBState *bbState, Int prev_flush, GN_(Flush) flushType)
      * - insert event capture instrumentation
      */
 
+    if (GN_(clo).gen_bb == True)
+        GN_(addEvent_BBSegment)(bbState);
+
     for (Int i = flush_from; i < flush_to; ++i)
         addStmtToIRSB(nbb, obb->stmts[i]);
-    gnInstrument_skipIfEventGenDisabled(nbb, skip_dst, skip_jk);
-    gnInstrument_EventCapture(nbb, bbState->hWordTy, bbState->eventsToFlush);
+    if (bbState->eventsToFlush > 0) {
+        gnInstrument_skipIfEventGenDisabled(nbb, skip_dst, skip_jk);
+        gnInstrument_EventCapture(nbb, bbState->hWordTy, bbState->eventsToFlush);
+    }
 
     /* add the exit after instrumentation */
     if (flushType.tag == GN_FLUSH_EXIT_ST)
@@ -890,11 +976,14 @@ void GN_(flush_Sync)(SyncType type, SyncID *data, UInt args)
     slot->tag = PRISM_SYNC_TAG;
     slot->sync.type = type;
 
-    UInt i=0;
-    for (; i<args; ++i)
-        slot->sync.data[i] = data[i];
-    for (; i<MAX_SYNC_DATA; ++i)
-        slot->sync.data[i] = UNUSED_SYNC_DATA;
+    /* a swap always carries its thread */
+    if (GN_(clo).gen_sync_args == True || type == PRISM_SYNC_SWAP) {
+        UInt i=0;
+        for (; i<args; ++i)
+            slot->sync.data[i] = data[i];
+        for (; i<MAX_SYNC_DATA; ++i)
+            slot->sync.data[i] = UNUSED_SYNC_DATA;
+    }
 
     /* increment event slot */
     ++GN_(currEv);
@@ -911,6 +1000,67 @@ void GN_(flush_Sync)(SyncType type, SyncID *data, UInt args)
 }
 
 
+void GN_(flush_Cxt)(CxtType type, PtrVal id)
+{
+    /* Like synchronization events, context markers are written directly
+     * to the current buffer from a client request */
+
+    GN_ASSERT(GN_(currEv) < GN_(endEv));
+
+    PrismEvVariant *slot = GN_(currEv);
+    slot->tag = PRISM_CXT_TAG;
+    slot->cxt.type = type;
+    slot->cxt.id = id;
+
+    ++GN_(currEv);
+    ++*GN_(usedEv);
+    if (GN_(currEv) == GN_(endEv))
+        GN_(flushCurrAndSetNextBuffer)();
+
+    GN_DEBUG(6, "CxtEvent: %u; Id: %lu\n", (UInt)type, (UWord)id);
+}
+
+
+void GN_(switchTranslations)(void)
+{
+    /* Without function tracking, blocks where events are not generated
+     * are translated without event instrumentation (see gn_instrument).
+     * Drop every cached translation so blocks are translated again in
+     * the version for the new state.
+     * With function tracking, the instrumentation must stay to keep the
+     * call stack consistent, and only event generation is toggled. */
+    if (GN_(clo).gen_fn == False)
+        VG_(discard_translations_safely)((Addr)0x1000, ~(SizeT)0xfff, "gengrind");
+}
+
+
+void GN_(setInstrumentState)(const HChar *reason, Bool state)
+{
+    if (GN_(InstrumentationOn) == state)
+        return;
+
+    if (state == False) {
+        /* close the region of interest and hand the partial buffer
+         * to the backend, so it does not wait on an idle application */
+        GN_(flush_Cxt)(PRISM_CXT_ROI_END, roiCount);
+        GN_(flushCurrAndSetNextBuffer)();
+    }
+
+    GN_(InstrumentationOn) = state;
+    GN_(updateEventGeneration)();
+
+    if (state == True) {
+        ++roiCount;
+        GN_(flush_Cxt)(PRISM_CXT_ROI_BEGIN, roiCount);
+    }
+
+    GN_(switchTranslations)();
+
+    VG_(message)(Vg_DebugMsg, "%s: instrumentation switched %s\n",
+                 reason, state ? "ON" : "OFF");
+}
+
+
 void GN_(flush_FnEnter)(const HChar *fnname)
 {
     GN_DEBUG(6, "Fn Enter: %s\n", fnname);
@@ -925,7 +1075,14 @@ void GN_(flush_FnExit)(const HChar *fnname)
 
 void GN_(updateEventGeneration)(void)
 {
-    if (GN_(afterStartFunc) == True &&
+    GN_(setSampleCollecting)(GN_(InstrumentationOn) == True &&
+                             GN_(afterStartFunc) == True &&
+                             GN_(afterEndFunc) == False &&
+                             GN_(isInSyncCall)() == False);
+
+    if (GN_(InstrumentationOn) == True &&
+            GN_(InSample) == True &&
+            GN_(afterStartFunc) == True &&
             GN_(afterEndFunc) == False &&
             GN_(isInSyncCall)() == False) {
         GN_(EventGenerationEnabled) = True;
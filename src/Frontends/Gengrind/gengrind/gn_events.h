@@ -58,6 +58,10 @@ extern GnJumpKind GN_(EvJumps)[GN_MAX_JUMPS_PER_BB];
 
 extern Bool GN_(EventGenerationEnabled);
 
+extern Bool GN_(InstrumentationOn);
+/* Region of interest state, set by --instr-atstart and toggled via
+ * client requests. Events are only generated inside the region. */
+
 
 enum GN_(FlushTag) {
     GN_FLUSH_EXIT_ST,
@@ -95,6 +99,10 @@ void GN_(flushEvents)(BBState *bbState, Int flush_from, GN_(Flush) flushType);
 
 void GN_(updateEventGeneration)(void);
 
+void GN_(flush_Cxt)(CxtType type, PtrVal id);
+void GN_(setInstrumentState)(const HChar *reason, Bool state);
+void GN_(switchTranslations)(void);
+
 void GN_(addEvent_Memory_Guarded_Load)(BBState *bbState, const IRStmt *st);
 void GN_(addEvent_Memory_Guarded_Store)(BBState *bbState, const IRStmt *st);
 /* unsupported events */
@@ -251,6 +251,7 @@ static inline FnNode* newFnNode(const HChar *fnname, FileNode *const file,
     fn->zero_before    = False;
     fn->toggle_collect = False;
     fn->skip           = False;
+    fn->filtered       = False;
     fn->pop_on_jump    = False;
     fn->is_malloc      = False;
     fn->is_free        = False;
@@ -424,6 +425,44 @@ ObjNode* GN_(getObjNodeByAddr)(Addr addr)
 }
 
 
+static Bool matchesAny(const GN_(FilterList) *list, const HChar *name)
+{
+    for (UInt i=0; i<list->count; ++i)
+        if (VG_(string_match)(list->patterns[i], name))
+            return True;
+    return False;
+}
+
+
+static Bool objMatchesAny(const GN_(FilterList) *list, const ObjNode *obj)
+{
+    /* patterns with a '/' match the full path of the object,
+     * others just its file name, e.g. 'libc*' */
+    for (UInt i=0; i<list->count; ++i) {
+        const HChar *pattern = list->patterns[i];
+        const HChar *name = VG_(strchr)(pattern, '/') ? obj->name
+                                                      : obj->name + obj->last_slash_pos;
+        if (VG_(string_match)(pattern, name))
+            return True;
+    }
+    return False;
+}
+
+
+static Bool isFiltered(const FnNode *fn)
+{
+    const ObjNode *obj = fn->file->obj;
+
+    if (GN_(clo).include_fn.count > 0 && !matchesAny(&GN_(clo).include_fn, fn->name))
+        return True;
+    if (GN_(clo).include_obj.count > 0 && !objMatchesAny(&GN_(clo).include_obj, obj))
+        return True;
+
+    return matchesAny(&GN_(clo).exclude_fn, fn->name) ||
+           objMatchesAny(&GN_(clo).exclude_obj, obj);
+}
+
+
 FnNode* GN_(getFnNode)(BBInfo *bb)
 {
     /* Return if already cached
@@ -477,6 +516,14 @@ FnNode* GN_(getFnNode)(BBInfo *bb)
         fn->is_realloc = (VG_(strcmp)(fn->name, "realloc") == 0);
         fn->is_free    = (VG_(strcmp)(fn->name, "free") == 0);
 
+        if (GN_(clo).filter_fns == True) {
+            fn->filtered = isFiltered(fn);
+            GN_DEBUGIF(1) {
+                if (fn->filtered == True)
+                    VG_(printf)("Filtered function: %s (%s)\n", fn->name, fn->file->obj->name);
+            }
+        }
+
         /* TODO(soon) update fn config (dump before/after, toggle collect, et al) */
 
         fn->initialized = True;
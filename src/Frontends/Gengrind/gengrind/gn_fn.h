@@ -57,6 +57,7 @@ struct _FnNode {
     Bool zero_before    : 1;
     Bool toggle_collect : 1;
     Bool skip           : 1; // currently unused, see Callgrind
+    Bool filtered       : 1; // excluded by --include/--exclude-fn/obj
     Bool pop_on_jump    : 1; // currently unused, see Callgrind
 
     Bool is_malloc      : 1;
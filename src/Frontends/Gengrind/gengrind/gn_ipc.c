@@ -1,11 +1,12 @@
 #include "gn_ipc.h"
 #include "gn_clo.h"
+#include "gn_events.h"
 #include "coregrind/pub_core_libcfile.h"
 #include "coregrind/pub_core_aspacemgr.h"
 #include "coregrind/pub_core_syscall.h"
 #include "pub_tool_basics.h"
 #include "pub_tool_vki.h"       // errnum, vki_timespec
-#include "pub_tool_vkiscnums.h" // __NR_nanosleep
+#include "pub_tool_vkiscnums.h" // __NR_nanosleep, __NR_futex
 
 static Bool initialized = False;
 static Int gnEmptyFd;
@@ -26,10 +27,65 @@ static EventBuffer   *gnCurrEvBuf;
 /* cached IPC state */
 
 
-static Bool isFull[PRISM_IPC_BUFFERS];
+static UInt gnBufferCount;
+static UInt gnEventCapacity;
+/* buffer configuration chosen by Prism, see PrismIPCHeader */
+
+static Bool isFull[PRISM_IPC_MAX_BUFFERS];
 /* track available buffers */
 
 
+static UInt gnTransport;
+static UInt gnProduced;
+/* futex transport: buffers filled so far,
+ * see PrismIPCHeader in CommonShmemIPC.h */
+
+
+static inline SysRes futex(UInt *addr, Int op, UInt val, struct vki_timespec *timeout)
+{
+    return VG_(do_syscall6)(__NR_futex, (UWord)addr, op, val, (UWord)timeout, 0, 0);
+}
+
+
+static void checkPrismAlive(void)
+{
+    /* Prism keeps its end of the 'empty' fifo open until
+     * the event stream is finished */
+    struct vki_pollfd pfd;
+    pfd.fd      = gnEmptyFd;
+    pfd.events  = VKI_POLLIN;
+    pfd.revents = 0;
+    if (VG_(poll)(&pfd, 1, 0) > 0 && (pfd.revents & VKI_POLLHUP)) {
+        VG_(umsg)("Prism disconnected unexpectedly\n");
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+}
+
+
+static void waitForEmptyBuffer(void)
+{
+    /* Block only if every buffer is still waiting to be consumed by Prism */
+    PrismIPCHeader *header = &gnShmem->header;
+    struct vki_timespec timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_nsec = PRISM_IPC_FUTEX_TIMEOUT_NS;
+
+    UInt consumed = __atomic_load_n(&header->consumed, __ATOMIC_ACQUIRE);
+    while (gnProduced - consumed >= gnBufferCount) {
+        __atomic_store_n(&header->producerWaiting, 1, __ATOMIC_SEQ_CST);
+        consumed = __atomic_load_n(&header->consumed, __ATOMIC_SEQ_CST);
+        if (gnProduced - consumed >= gnBufferCount) {
+            SysRes res = futex(&header->consumed, VKI_FUTEX_WAIT, consumed, &timeout);
+            if (sr_isError(res) && sr_Err(res) == VKI_ETIMEDOUT)
+                checkPrismAlive();
+        }
+        __atomic_store_n(&header->producerWaiting, 0, __ATOMIC_SEQ_CST);
+        consumed = __atomic_load_n(&header->consumed, __ATOMIC_ACQUIRE);
+    }
+}
+
+
 //static inline void set_next_buffer(void)
 //{
 //    /* try the next buffer, circular */
@@ -108,6 +164,46 @@ static Bool isFull[PRISM_IPC_BUFFERS];
 //}
 
 
+static void setBuffer(UInt idx)
+{
+    /* Point the event generation at the start of buffer 'idx' */
+    gnCurrEvBuf = prismIPCEventBuffer(&gnShmem->header, idx);
+    gnCurrEvBuf->used = 0;
+    GN_(currEv) = gnCurrEvBuf->events + gnCurrEvBuf->used;
+    GN_(usedEv) = &gnCurrEvBuf->used;
+    GN_(endEv) = gnCurrEvBuf->events + gnEventCapacity;
+}
+
+
+static void initBufferConfig(void)
+{
+    gnBufferCount   = gnShmem->header.bufferCount;
+    gnEventCapacity = gnShmem->header.eventCapacity;
+    tl_assert(gnBufferCount >= 2 && gnBufferCount <= PRISM_IPC_MAX_BUFFERS);
+    tl_assert((gnBufferCount & (gnBufferCount - 1)) == 0);
+
+    /* all events for a superblock are reserved at once */
+    tl_assert(gnEventCapacity >= GN_MAX_EVENTS_PER_BB);
+
+    /* the instrumentation writes packed events inline */
+    if (gnShmem->header.encoding != PRISM_EVENTS_PACKED) {
+        VG_(umsg)("Gengrind only supports the packed event encoding\n");
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    /* all threads share channel 0 */
+    if (gnShmem->header.channelCount != 1) {
+        VG_(umsg)("Gengrind only supports a single Prism thread\n");
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    for (UInt i=0; i<gnBufferCount; ++i)
+        isFull[i] = False;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 /** Initialization/Termination **/
 
@@ -158,7 +254,16 @@ static PrismDBISharedData* openShmem(const HChar *gnShmem_path, int flags)
         VG_(exit)(1);
     }
 
-    SysRes res = VG_(am_shared_mmap_file_float_valgrind)(sizeof(PrismDBISharedData),
+    /* Prism sizes the file to fit the buffer configuration
+     * it wrote into the header */
+    Long shared_mem_size = VG_(fsize)(shared_mem_fd);
+    if (shared_mem_size < (Long)sizeof(PrismDBISharedData)) {
+        VG_(umsg)("Shared_mem file %s is too small\n", gnShmem_path);
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    SysRes res = VG_(am_shared_mmap_file_float_valgrind)(shared_mem_size,
                                                          VKI_PROT_READ|VKI_PROT_WRITE,
                                                          shared_mem_fd, (Off64T)0);
     if (sr_isError(res)) {
@@ -171,7 +276,14 @@ static PrismDBISharedData* openShmem(const HChar *gnShmem_path, int flags)
     Addr addr_shared = sr_Res (res);
     VG_(close)(shared_mem_fd);
 
-    return (PrismDBISharedData*) addr_shared;
+    PrismDBISharedData *shared = (PrismDBISharedData*) addr_shared;
+    if (shared->header.totalSize > (ULong)shared_mem_size) {
+        VG_(umsg)("Shared_mem file %s does not match its header\n", gnShmem_path);
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    return shared;
 }
 
 
@@ -180,20 +292,17 @@ void GN_(initIPC)()
     tl_assert(initialized == False);
 
     if (GN_(clo).standalone_test == True) {
-        gnShmem = VG_(malloc)("gn.test.buffer", sizeof(*gnShmem));
+        PrismIPCHeader layout;
+        SizeT size = prismIPCLayout(&layout, PRISM_IPC_BUFFERS, PRISM_EVENTS_BUFFER_SIZE,
+                                    PRISM_NAMES_BUFFER_SIZE, PRISM_EVENTS_PACKED, 0);
+        gnShmem = VG_(malloc)("gn.test.buffer", size);
+        gnShmem->header = layout;
+        gnShmem->header.channel = 0;
+        gnShmem->header.channelCount = 1;
+        initBufferConfig();
 
         gnNextIdx = 0;
-        gnCurrEvBuf = gnShmem->eventBuffers + gnNextIdx;
-        gnCurrEvBuf->used = 0;
-        GN_(currEv) = gnCurrEvBuf->events + gnCurrEvBuf->used;
-        GN_(usedEv) = &gnCurrEvBuf->used;
-
-        /* ensure events is an array, not a pointer */
-        tl_assert(sizeof(gnCurrEvBuf->events) != sizeof(gnCurrEvBuf->events[0]));
-        GN_(endEv) = gnCurrEvBuf->events + sizeof(gnCurrEvBuf->events)/sizeof(gnCurrEvBuf->events[0]);
-        for (UInt i=0; i<PRISM_IPC_BUFFERS; ++i)
-            isFull[i] = False;
-
+        setBuffer(gnNextIdx);
         ++gnNextIdx;
 
         initialized = True;
@@ -226,13 +335,16 @@ void GN_(initIPC)()
     gnShmem   = openShmem(gnShmemPath, VKI_O_RDWR);
 
     /* initialize cached IPC state */
+    gnTransport = gnShmem->header.transport;
+    tl_assert(gnTransport == PRISM_IPC_TRANSPORT_FIFO ||
+              gnTransport == PRISM_IPC_TRANSPORT_FUTEX);
+    gnProduced = 0;
+    initBufferConfig();
     GN_(currEv) = NULL;
     GN_(endEv) = NULL;
     gnCurrIdx = 0;
     gnNextIdx = 0;
     GN_(setNextBuffer)();
-    for (UInt i=0; i<PRISM_IPC_BUFFERS; ++i)
-        isFull[i] = False;
 
     initialized = True;
 }
@@ -258,7 +370,11 @@ void GN_(termIPC)(void)
 
     /* ... and send finish sequence */
     UInt finished = PRISM_IPC_FINISHED;
-    if (VG_(write)(gnFullFd, &finished, sizeof(finished)) != sizeof(finished)) {
+    if (gnTransport == PRISM_IPC_TRANSPORT_FUTEX) {
+        __atomic_store_n(&gnShmem->header.finished, 1, __ATOMIC_SEQ_CST);
+        futex(&gnShmem->header.produced, VKI_FUTEX_WAKE, 1, NULL);
+    }
+    else if (VG_(write)(gnFullFd, &finished, sizeof(finished)) != sizeof(finished)) {
         VG_(umsg)("error VG_(write)\n");
         VG_(umsg)("error writing to Sigrind fifo\n");
         VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
@@ -275,6 +391,16 @@ void GN_(termIPC)(void)
 
 void GN_(flushCurrBuffer)(void)
 {
+    if (gnTransport == PRISM_IPC_TRANSPORT_FUTEX) {
+        /* Publish the buffer, and only wake Prism
+         * if it ran out of full buffers */
+        PrismIPCHeader *header = &gnShmem->header;
+        __atomic_store_n(&header->produced, ++gnProduced, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&header->consumerWaiting, __ATOMIC_SEQ_CST) != 0)
+            futex(&header->produced, VKI_FUTEX_WAKE, 1, NULL);
+        return;
+    }
+
     /* Mark that the buffer is being flushed,
      * and tell Prism the buffer is ready to consume */
     isFull[gnCurrIdx] = True;
@@ -291,12 +417,16 @@ void GN_(flushCurrBuffer)(void)
 void GN_(setNextBuffer)(void)
 {
     /* try the next buffer, circular */
-    if (gnNextIdx == PRISM_IPC_BUFFERS)
+    if (gnNextIdx == gnBufferCount)
         gnNextIdx = 0;
 
     /* if the next buffer is full,
      * wait until Prism communicates that it's free */
-    if (isFull[gnNextIdx]) {
+    if (gnTransport == PRISM_IPC_TRANSPORT_FUTEX) {
+        waitForEmptyBuffer();
+        tl_assert(gnProduced % gnBufferCount == gnNextIdx);
+    }
+    else if (isFull[gnNextIdx]) {
         UInt bufIdx;
         Int res = VG_(read)(gnEmptyFd, &bufIdx, sizeof(bufIdx));
         if (res != sizeof(bufIdx)) {
@@ -306,19 +436,12 @@ void GN_(setNextBuffer)(void)
             VG_(exit)(1);
         }
 
-        tl_assert(bufIdx < PRISM_IPC_BUFFERS);
+        tl_assert(bufIdx < gnBufferCount);
         tl_assert(bufIdx == gnNextIdx);
         isFull[gnNextIdx] = False;
     }
 
-    gnCurrEvBuf = gnShmem->eventBuffers + gnNextIdx;
-    gnCurrEvBuf->used = 0;
-    GN_(currEv) = gnCurrEvBuf->events + gnCurrEvBuf->used;
-    GN_(usedEv) = &gnCurrEvBuf->used;
-
-    /* ensure events is an array, not a pointer */
-    tl_assert(sizeof(gnCurrEvBuf->events) != sizeof(gnCurrEvBuf->events[0]));
-    GN_(endEv) = gnCurrEvBuf->events + sizeof(gnCurrEvBuf->events)/sizeof(gnCurrEvBuf->events[0]);
+    setBuffer(gnNextIdx);
 
     //currNameBuf = gnShmem->nameBuffers + currIdx;
     //currNameBuf->used = 0;
@@ -332,15 +455,9 @@ void GN_(setNextBuffer)(void)
 void GN_(flushCurrAndSetNextBuffer)(void)
 {
     if (GN_(clo).standalone_test == True) {
-        gnCurrEvBuf = gnShmem->eventBuffers + gnNextIdx;
-        gnCurrEvBuf->used = 0;
-        GN_(currEv) = gnCurrEvBuf->events + gnCurrEvBuf->used;
-        GN_(usedEv) = &gnCurrEvBuf->used;
-
-        /* ensure events is an array, not a pointer */
-        tl_assert(sizeof(gnCurrEvBuf->events) != sizeof(gnCurrEvBuf->events[0]));
-        GN_(endEv) = gnCurrEvBuf->events + sizeof(gnCurrEvBuf->events)/sizeof(gnCurrEvBuf->events[0]);
-
+        if (gnNextIdx == gnBufferCount)
+            gnNextIdx = 0;
+        setBuffer(gnNextIdx);
         ++gnNextIdx;
     }
     else {
@@ -36,9 +36,11 @@
 #include "gn_ipc.h"
 #include "gn_clo.h"
 #include "gn_bb.h"
+#include "gn_fn.h"
 #include "gn_events.h"
 #include "gn_threads.h"
 #include "gn_crq.h"
+#include "gn_sample.h"
 #include "gn_callstack.h"
 #include "gn_jumps.h"
 #include "gn_debug.h"
@@ -46,15 +48,26 @@
 
 static void gn_post_clo_init(void)
 {
-    if (GN_(clo).gen_fn) {
+    if (GN_(clo).gen_fn || GN_(clo).gen_bb || GN_(clo).filter_fns) {
         GN_(clo).bbinfo_needed = True;
     }
 
+    /* a block event carries the count of its instructions,
+     * so instructions would be counted twice */
+    if (GN_(clo).gen_bb == True)
+        GN_(clo).gen_instr = False;
+
+    /* a batch has no room for the arity of each op */
+    if (GN_(clo).gen_comp_arity == True)
+        GN_(clo).gen_comp_batch = False;
+
     GN_(initIPC)();
     GN_(initializeThreadState)();
 
-    if (GN_(clo).gen_fn == True) {
+    if (GN_(clo).bbinfo_needed == True)
         GN_(initBB)();
+
+    if (GN_(clo).gen_fn == True) {
         GN_(initCallStack)();
         GN_(initJumpTable)();
         GN_(lastJmpsPassed) = 0;
@@ -65,6 +78,11 @@ static void gn_post_clo_init(void)
         GN_(afterStartFunc) = True;
     else
         GN_(afterStartFunc) = False;
+
+    /* the region of interest can be delayed until a client request */
+    GN_(InstrumentationOn) = GN_(clo).instr_atstart;
+    GN_(initSampling)();
+    GN_(updateEventGeneration)();
 }
 
 
@@ -112,11 +130,31 @@ IRSB* gn_instrument ( VgCallbackClosure* closure,
         return obb;
     }
 
+    // Nor outside the region of interest, unless the call stack is tracked
+    if (GN_(InstrumentationOn) == False && GN_(clo).gen_fn == False) {
+        GN_DEBUG(5, "instrument(BB %#lx) [Outside ROI]\n",
+                  (Addr)closure->readdr);
+        return obb;
+    }
+
+    // Or between samples, where only instructions are counted
+    if (GN_(InSample) == False && GN_(clo).gen_fn == False &&
+            GN_(clo).sample_retranslate == True) {
+        GN_DEBUG(5, "instrument(BB %#lx) [Fast-forward]\n",
+                  (Addr)closure->readdr);
+        return GN_(instrumentFastForward)(obb);
+    }
+
     BBState bbState;
     Int i = GN_(initBBState)(&bbState, obb, hWordTy);
 
     GN_DEBUG(3, "+ instrument(BB %#lx)(%d)\n", (Addr)closure->readdr, bbState.bbInfo->uid);
 
+    // Superblocks do not cross functions (guest_chase_thresh is 0),
+    // so a filtered function is decided once per translation
+    if (GN_(clo).filter_fns == True)
+        bbState.filtered = GN_(getFnNode)(bbState.bbInfo)->filtered;
+
     // pre-BB instrumentation
     {
         if (GN_(clo).gen_fn == True)
@@ -124,6 +162,9 @@ IRSB* gn_instrument ( VgCallbackClosure* closure,
 
         if (GN_(clo).gen_sync == True)
             GN_(add_TrackSyncs)(&bbState); // Need to setup thread context instrumentation
+
+        if (GN_(clo).sample_period > 0)
+            GN_(add_SampleCount)(&bbState); // Fast-forward or sample this BB
     }
 
     // BB instrumentation
@@ -134,6 +175,20 @@ IRSB* gn_instrument ( VgCallbackClosure* closure,
         const IRStmt *st = obb->stmts[i];
         GN_ASSERT(isFlatIRStmt(st));
 
+        if (bbState.filtered == True) {
+            // No events; only the exits are still needed for jump tracking
+            if (st->tag == Ist_IMark) {
+                curr_instr_idx = i;
+            }
+            else if (st->tag == Ist_Exit) {
+                GN_(addEvent_Exit)(&bbState, st);
+                GN_(Flush) f = {GN_FLUSH_EXIT_ST, curr_instr_idx, i};
+                GN_(flushEvents)(&bbState, prev_flushed_idx, f);
+                prev_flushed_idx = i;
+            }
+            continue;
+        }
+
         switch (st->tag) {
         case Ist_NoOp:
         case Ist_AbiHint:
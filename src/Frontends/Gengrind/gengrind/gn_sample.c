@@ -0,0 +1,200 @@
+#include "gn_sample.h"
+#include "gn_events.h"
+#include "gn_ipc.h"
+#include "gn_clo.h"
+#include "gn_bb.h"
+#include "gn_debug.h"
+
+Bool GN_(InSample);
+ULong GN_(guestInstrs);
+ULong GN_(nextSampleBoundary);
+
+static Bool collecting = True;
+static ULong pausedAt = 0;
+static ULong pausedInstrs = 0;
+/* guest instructions while the sampling clock was paused */
+
+//-------------------------------------------------------------------------------------------------
+/** Helper function definitions **/
+
+static Bool inSampleAt(ULong instrs)
+{
+    ULong period = GN_(clo).sample_period;
+    ULong length = GN_(clo).sample_length;
+    return instrs % period >= period - length;
+}
+
+
+static ULong nextBoundaryAfter(ULong instrs)
+{
+    ULong period = GN_(clo).sample_period;
+    ULong length = GN_(clo).sample_length;
+    ULong base = instrs - instrs % period;
+    return inSampleAt(instrs) ? base + period : base + (period - length);
+}
+
+
+static ULong collectedInstrs(void)
+{
+    return (collecting == True ? GN_(guestInstrs) : pausedAt) - pausedInstrs;
+}
+
+
+static void scheduleBoundary(void)
+{
+    /* boundaries are in collected instructions, and checked against
+     * the guest instruction count; none are crossed while paused */
+    if (GN_(clo).sample_period == 0)
+        return;
+    GN_(nextSampleBoundary) = collecting == True ?
+        nextBoundaryAfter(collectedInstrs()) + pausedInstrs : ~0ULL;
+}
+
+
+static VG_REGPARM(0) void sampleBoundary(void)
+{
+    /* Called from a basic block that reached the next boundary.
+     * Instructions are counted per block, so a boundary is observed
+     * at the first block that crosses it; a block crossing a whole
+     * window (only with tiny lengths) skips that window. */
+
+    ULong instrs = collectedInstrs();
+    Bool inSample = inSampleAt(instrs);
+    scheduleBoundary();
+
+    if (inSample == GN_(InSample))
+        return;
+
+    if (inSample == False) {
+        /* hand the sample to the backend while fast-forwarding */
+        GN_(flush_Cxt)(PRISM_CXT_SAMPLE_END, instrs);
+        GN_(flushCurrAndSetNextBuffer)();
+    }
+
+    GN_(InSample) = inSample;
+    GN_(updateEventGeneration)();
+
+    if (inSample == True)
+        GN_(flush_Cxt)(PRISM_CXT_SAMPLE_BEGIN, instrs);
+
+    if (GN_(clo).sample_retranslate == True)
+        GN_(switchTranslations)();
+
+    GN_DEBUG(2, "Sample %s at %llu instructions\n",
+             inSample ? "begin" : "end", instrs);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+/** External function definitions **/
+
+void GN_(initSampling)(void)
+{
+    GN_(guestInstrs) = 0;
+
+    if (GN_(clo).sample_period < 0)
+        VG_(fmsg_bad_option)("--sample-period", "must not be negative\n");
+
+    if (GN_(clo).sample_period == 0) {
+        GN_(InSample) = True;
+        GN_(nextSampleBoundary) = ~0ULL;
+        return;
+    }
+
+    if (GN_(clo).sample_length <= 0 ||
+            GN_(clo).sample_length > GN_(clo).sample_period)
+        VG_(fmsg_bad_option)("--sample-length",
+                             "must be between 1 and --sample-period\n");
+
+    GN_(InSample) = inSampleAt(0);
+    scheduleBoundary();
+}
+
+
+void GN_(setSampleCollecting)(Bool on)
+{
+    /* Instructions that generate no events, regardless of sampling,
+     * are neither sampled nor elapsed; otherwise the backends would
+     * extrapolate from windows with no events in them */
+    if (on == collecting)
+        return;
+
+    if (on == False)
+        pausedAt = GN_(guestInstrs);
+    else
+        pausedInstrs += GN_(guestInstrs) - pausedAt;
+    collecting = on;
+    scheduleBoundary();
+}
+
+
+static void addSampleCount(IRSB *obb, IRSB *nbb)
+{
+    ULong instrs = 0;
+    for (Int i = 0; i < obb->stmts_used; ++i)
+        if (obb->stmts[i]->tag == Ist_IMark)
+            ++instrs;
+
+    /* tmp1 <- guestInstrs + instrs */
+    IRTemp countTmp = newIRTemp(nbb->tyenv, Ity_I64);
+    IRTemp sumTmp = newIRTemp(nbb->tyenv, Ity_I64);
+    addStmtToIRSB(nbb,
+                  IRStmt_WrTmp(countTmp,
+                               IRExpr_Load(ENDNESS, Ity_I64,
+                                           mkIRExpr_HWord((HWord)&GN_(guestInstrs)))));
+    addStmtToIRSB(nbb,
+                  IRStmt_WrTmp(sumTmp,
+                               IRExpr_Binop(Iop_Add64,
+                                            IRExpr_RdTmp(countTmp),
+                                            IRExpr_Const(IRConst_U64(instrs)))));
+    addStmtToIRSB(nbb,
+                  IRStmt_Store(ENDNESS,
+                               mkIRExpr_HWord((HWord)&GN_(guestInstrs)),
+                               IRExpr_RdTmp(sumTmp)));
+
+    /* tmp2 <- (nextSampleBoundary <= tmp1) */
+    IRTemp boundaryTmp = newIRTemp(nbb->tyenv, Ity_I64);
+    IRTemp crossedTmp = newIRTemp(nbb->tyenv, Ity_I1);
+    addStmtToIRSB(nbb,
+                  IRStmt_WrTmp(boundaryTmp,
+                               IRExpr_Load(ENDNESS, Ity_I64,
+                                           mkIRExpr_HWord((HWord)&GN_(nextSampleBoundary)))));
+    addStmtToIRSB(nbb,
+                  IRStmt_WrTmp(crossedTmp,
+                               IRExpr_Binop(Iop_CmpLE64U,
+                                            IRExpr_RdTmp(boundaryTmp),
+                                            IRExpr_RdTmp(sumTmp))));
+
+    /* if (tmp2) sampleBoundary() */
+    IRExpr **argv = mkIRExprVec_0();
+    IRDirty *di = unsafeIRDirty_0_N(0, "sampleBoundary",
+                                    VG_(fnptr_to_fnentry)(sampleBoundary), argv);
+    di->guard = IRExpr_RdTmp(crossedTmp);
+    addStmtToIRSB(nbb, IRStmt_Dirty(di));
+}
+
+
+void GN_(add_SampleCount)(BBState *bbState)
+{
+    /* Count the guest instructions of this block up front,
+     * and check for a sample boundary before any of its events.
+     *
+     * This is expected to be instrumented at the beginning of the BB */
+
+    addSampleCount(bbState->obb, bbState->nbb);
+}
+
+
+IRSB* GN_(instrumentFastForward)(IRSB *obb)
+{
+    /* The fast-forward version of a block: the original block with only
+     * the instruction count. It generates no events and has no check
+     * on event generation; translations are discarded when a sample
+     * begins, and the block is translated again with full instrumentation */
+
+    IRSB *nbb = deepCopyIRSBExceptStmts(obb);
+    addSampleCount(obb, nbb);
+    for (Int i = 0; i < obb->stmts_used; ++i)
+        addStmtToIRSB(nbb, obb->stmts[i]);
+    return nbb;
+}
@@ -0,0 +1,38 @@
+#ifndef GN_SAMPLE_H
+#define GN_SAMPLE_H
+
+#include "gn.h"
+
+/* Periodic sampling of the event stream.
+ *
+ * Guest instructions are counted in every instrumented basic block.
+ * Of every --sample-period instructions, the first
+ * (period - length) are fast-forwarded without generating events,
+ * and the last --sample-length are traced.
+ * Each traced window is bracketed with PRISM_CXT_SAMPLE_BEGIN/END
+ * context events, whose ids are the guest instruction count at the
+ * boundary, so backends can extrapolate their totals.
+ *
+ * Only instructions that would otherwise generate events are sampled:
+ * outside the region of interest, the start/end functions, or sync
+ * calls, the sampling clock is paused and no boundaries are crossed.
+ *
+ * Unless functions are tracked, a block has two versions: fully
+ * instrumented inside a sample, and only counting instructions while
+ * fast-forwarding. Cached translations are discarded at each boundary
+ * (--sample-retranslate=yes) to switch between them. */
+
+extern Bool GN_(InSample);
+/* always True when sampling is off */
+
+extern ULong GN_(guestInstrs);
+extern ULong GN_(nextSampleBoundary);
+
+//-------------------------------------------------------------------------------------------------
+void GN_(initSampling)(void);
+void GN_(setSampleCollecting)(Bool on);
+/* pause or resume the sampling clock */
+void GN_(add_SampleCount)(BBState *bbState);
+IRSB* GN_(instrumentFastForward)(IRSB *obb);
+
+#endif
@@ -41,6 +41,10 @@ static void switchThread(ThreadId tid)
     GN_(currentTid) = utid;
     isInSyncCall = threadStateTable[utid].isInSyncCall;
     GN_(EventGenerationEnabled) = threadStateTable[GN_(currentTid)].eventGenerationEnabled;
+
+    /* the region of interest is process-wide and may have
+     * changed while this thread was not running */
+    GN_(updateEventGeneration)();
 }
 
 
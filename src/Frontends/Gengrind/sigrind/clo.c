@@ -422,6 +422,12 @@ Bool CLG_(process_cmd_line_option)(const HChar* arg)
    else if VG_BOOL_CLO(arg, "--gen-fn",     SGL_(clo).gen_fn) {}
    else if VG_BOOL_CLO(arg, "--gen-cf",     SGL_(clo).gen_cf) {}
    else if VG_BOOL_CLO(arg, "--gen-bb",     SGL_(clo).gen_bb) {}
+   else if VG_BOOL_CLO(arg, "--gen-mem-ldst",   SGL_(clo).gen_mem_ldst) {}
+   else if VG_BOOL_CLO(arg, "--gen-mem-size",   SGL_(clo).gen_mem_size) {}
+   else if VG_BOOL_CLO(arg, "--gen-mem-addr",   SGL_(clo).gen_mem_addr) {}
+   else if VG_BOOL_CLO(arg, "--gen-comp-type",  SGL_(clo).gen_comp_type) {}
+   else if VG_BOOL_CLO(arg, "--gen-comp-arity", SGL_(clo).gen_comp_arity) {}
+   else if VG_BOOL_CLO(arg, "--gen-sync-args",  SGL_(clo).gen_sync_args) {}
 
    /* XXX
     * ML: leftover from Callgrind. Most of these should be left at defaults
@@ -639,6 +645,12 @@ void SGL_(set_clo_defaults)(void)
   SGL_(clo).gen_bb             = False;
   SGL_(clo).gen_fn             = False;
   SGL_(clo).gen_thr            = False;
+  SGL_(clo).gen_mem_ldst       = True;
+  SGL_(clo).gen_mem_size       = True;
+  SGL_(clo).gen_mem_addr       = True;
+  SGL_(clo).gen_comp_type      = True;
+  SGL_(clo).gen_comp_arity     = False;
+  SGL_(clo).gen_sync_args      = True;
 }
 
 void CLG_(set_clo_defaults)(void)
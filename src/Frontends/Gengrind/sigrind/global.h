@@ -87,6 +87,16 @@ struct _SglCommandLineOptions {
   Bool gen_bb;
   Bool gen_fn;
   Bool gen_thr;
+
+  Bool gen_mem_ldst;
+  Bool gen_mem_size;
+  Bool gen_mem_addr;
+  Bool gen_comp_type;
+  Bool gen_comp_arity;
+  Bool gen_sync_args;
+  /* per-field filters within the event types above;
+   * a disabled field is sent as zero, except for the access size,
+   * which costs nothing extra in any encoding and is always sent */
 };
 
 typedef struct _CommandLineOptions CommandLineOptions;
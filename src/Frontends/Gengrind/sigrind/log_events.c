@@ -62,10 +62,23 @@ void SGL_(log_1I0D)(InstrInfo* ii)
         cxt_events++;
 #endif
 
-        PrismEvVariant* slot = SGL_(acq_event_slot)();
-        slot->tag          = PRISM_CXT_TAG;
-        slot->cxt.type     = PRISM_CXT_INSTR;
-        slot->cxt.id       = ii->instr_addr;
+        if (SGL_(ipc_compact) == True)
+        {
+            prismEncodeCxt(SGL_(acq_encoder)(), PRISM_CXT_INSTR, ii->instr_addr);
+        }
+        else if (SGL_(ipc_columns) == True)
+        {
+            PrismCxtSlot* slot = SGL_(acq_cxt_slot)();
+            slot->type         = PRISM_CXT_INSTR;
+            slot->id           = ii->instr_addr;
+        }
+        else
+        {
+            PrismEvVariant* slot = SGL_(acq_event_slot)();
+            slot->tag          = PRISM_CXT_TAG;
+            slot->cxt.type     = PRISM_CXT_INSTR;
+            slot->cxt.id       = ii->instr_addr;
+        }
     }
 }
 
@@ -81,11 +94,33 @@ static inline void log_mem(Int type, Addr data_addr, Word data_size)
         ++mem_events;
 #endif
 
-        PrismEvVariant* slot   = SGL_(acq_event_slot)();
-        slot->tag            = PRISM_MEM_TAG;
-        slot->mem.type       = type;
-        slot->mem.begin_addr = data_addr;
-        slot->mem.size       = data_size;
+        /* A zeroed address costs the compact encoding a single byte.
+         * The size is left alone: power of 2 sizes are free there,
+         * while an unknown size of 0 would need an escape */
+        if (SGL_(clo).gen_mem_ldst == False)
+            type = PRISM_MEM_TYPE_UNDEF;
+        if (SGL_(clo).gen_mem_addr == False)
+            data_addr = 0;
+
+        if (SGL_(ipc_compact) == True)
+        {
+            prismEncodeMem(SGL_(acq_encoder)(), type, data_addr, data_size);
+        }
+        else if (SGL_(ipc_columns) == True)
+        {
+            PrismMemSlot* slot   = SGL_(acq_mem_slot)();
+            slot->type           = type;
+            slot->begin_addr     = data_addr;
+            slot->size           = data_size;
+        }
+        else
+        {
+            PrismEvVariant* slot   = SGL_(acq_event_slot)();
+            slot->tag            = PRISM_MEM_TAG;
+            slot->mem.type       = type;
+            slot->mem.begin_addr = data_addr;
+            slot->mem.size       = data_size;
+        }
     }
 }
 void SGL_(log_0I1Dr)(InstrInfo* ii, Addr data_addr, Word data_size)
@@ -111,32 +146,54 @@ void SGL_(log_comp_event)(InstrInfo* ii, IRType op_type, IRExprTag arity)
         ++comp_events;
 #endif
 
-        PrismEvVariant* slot = SGL_(acq_event_slot)();
-        slot->tag = PRISM_COMP_TAG;
-
+        CompCostType type;
         if (op_type < Ity_F16)
-            slot->comp.type = PRISM_COMP_IOP;
+            type = PRISM_COMP_IOP;
         else
-            slot->comp.type = PRISM_COMP_FLOP;
+            type = PRISM_COMP_FLOP;
 
+        CompArity comp_arity = PRISM_COMP_UNARY;
         switch (arity)
         {
         case Iex_Unop:
-            slot->comp.arity = PRISM_COMP_UNARY;
+            comp_arity = PRISM_COMP_UNARY;
             break;
         case Iex_Binop:
-            slot->comp.arity = PRISM_COMP_BINARY;
+            comp_arity = PRISM_COMP_BINARY;
             break;
         case Iex_Triop:
-            slot->comp.arity = PRISM_COMP_TERNARY;
+            comp_arity = PRISM_COMP_TERNARY;
             break;
         case Iex_Qop:
-            slot->comp.arity = PRISM_COMP_QUARTERNARY;
+            comp_arity = PRISM_COMP_QUARTERNARY;
             break;
         default:
             tl_assert(False);
             break;
         }
+
+        if (SGL_(clo).gen_comp_type == False)
+            type = PRISM_COMP_TYPE_UNDEF;
+        if (SGL_(clo).gen_comp_arity == False)
+            comp_arity = PRISM_COMP_ARITY_UNDEF;
+
+        if (SGL_(ipc_compact) == True)
+        {
+            prismEncodeComp(SGL_(acq_encoder)(), type, comp_arity, 0, 0);
+        }
+        else if (SGL_(ipc_columns) == True)
+        {
+            PrismCompSlot* slot = SGL_(acq_comp_slot)();
+            slot->type  = type;
+            slot->arity = comp_arity;
+        }
+        else
+        {
+            PrismEvVariant* slot = SGL_(acq_event_slot)();
+            slot->tag        = PRISM_COMP_TAG;
+            slot->comp.type  = type;
+            slot->comp.arity = comp_arity;
+        }
     }
 }
 
@@ -149,15 +206,40 @@ void SGL_(log_sync)(UChar type, UWord data1, UWord data2)
         ++sync_events;
 #endif
 
-        PrismEvVariant* slot  = SGL_(acq_event_slot)();
-        slot->tag           = PRISM_SYNC_TAG;
-        slot->sync.type     = type;
-        slot->sync.data[0]  = data1;
-        slot->sync.data[1]  = data2;
+        /* a swap always carries its thread */
+        if (SGL_(clo).gen_sync_args == False && type != PRISM_SYNC_SWAP)
+            data1 = data2 = 0;
+
+        if (SGL_(ipc_compact) == True)
+        {
+            prismEncodeSync(SGL_(acq_encoder)(), type, data1, data2);
+        }
+        else if (SGL_(ipc_columns) == True)
+        {
+            PrismSyncSlot* slot = SGL_(acq_sync_slot)();
+            slot->type          = type;
+            slot->data[0]       = data1;
+            slot->data[1]       = data2;
+        }
+        else
+        {
+            PrismEvVariant* slot  = SGL_(acq_event_slot)();
+            slot->tag           = PRISM_SYNC_TAG;
+            slot->sync.type     = type;
+            slot->sync.data[0]  = data1;
+            slot->sync.data[1]  = data2;
+        }
     }
 }
 
 
+void SGL_(log_swap)(void)
+{
+    static UWord swap_seq = 0;
+    SGL_(log_sync)(PRISM_SYNC_SWAP, SGL_(active_tid), swap_seq++);
+}
+
+
 static inline void log_fn(Int type, fn_node* fn)
 {
     if (EVENT_GENERATION_ENABLED && SGL_(clo).gen_fn == True)
@@ -169,13 +251,32 @@ static inline void log_fn(Int type, fn_node* fn)
         /* request both slots simultaneously to allow proper flushing */
         /* TODO set max size for name length? */
         Int len = VG_(strlen)(fn->name) + 1;
-        EventNameSlotTuple tuple = SGL_(acq_event_name_slot)(len);
+        if (SGL_(ipc_compact) == True)
+        {
+            EncoderNameSlotTuple tuple = SGL_(acq_encoder_name_slot)(len);
+
+            VG_(strncpy)(tuple.name_slot, fn->name, len);
+            prismEncodeCxtName(tuple.encoder, type, tuple.name_idx, len);
+        }
+        else if (SGL_(ipc_columns) == True)
+        {
+            CxtNameSlotTuple tuple = SGL_(acq_cxt_name_slot)(len);
 
-        VG_(strncpy)(tuple.name_slot, fn->name, len);
-        tuple.event_slot->tag      = PRISM_CXT_TAG;
-        tuple.event_slot->cxt.type = type;
-        tuple.event_slot->cxt.len  = len;
-        tuple.event_slot->cxt.idx  = tuple.name_idx;
+            VG_(strncpy)(tuple.name_slot, fn->name, len);
+            tuple.cxt_slot->type = type;
+            tuple.cxt_slot->len  = len;
+            tuple.cxt_slot->idx  = tuple.name_idx;
+        }
+        else
+        {
+            EventNameSlotTuple tuple = SGL_(acq_event_name_slot)(len);
+
+            VG_(strncpy)(tuple.name_slot, fn->name, len);
+            tuple.event_slot->tag      = PRISM_CXT_TAG;
+            tuple.event_slot->cxt.type = type;
+            tuple.event_slot->cxt.len  = len;
+            tuple.event_slot->cxt.idx  = tuple.name_idx;
+        }
     }
 }
 void SGL_(log_fn_entry)(fn_node* fn)
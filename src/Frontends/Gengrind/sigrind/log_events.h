@@ -51,6 +51,12 @@ void SGL_(log_fn_leave)(fn_node* fn);
 #define UNUSED_SYNC_DATA 0
 void SGL_(log_sync)(UChar type, UWord data1, UWord data2);
 
+/* Thread context swap to the active thread
+ * The second data argument is a sequence number, counting every swap
+ * across all IPC channels, so that the interleaving of the per-channel
+ * event streams can be recovered */
+void SGL_(log_swap)(void);
+
 /* unimplemented */
 void SGL_(log_global_event)(InstrInfo* ii);
 
@@ -4,13 +4,13 @@
 #include "coregrind/pub_core_syscall.h"
 #include "pub_tool_basics.h"
 #include "pub_tool_vki.h"       // errnum, vki_timespec
-#include "pub_tool_vkiscnums.h" // __NR_nanosleep
+#include "pub_tool_vkiscnums.h" // __NR_nanosleep, __NR_futex
 
 static Bool initialized = False;
 static Int emptyfd;
 static Int fullfd;
 static PrismDBISharedData* shmem;
-/* IPC channel */
+/* current IPC channel */
 
 
 static UInt            curr_idx;
@@ -21,24 +21,167 @@ static char*           curr_name_slot;
 /* cached IPC state */
 
 
-static Bool is_full[PRISM_IPC_BUFFERS];
+Bool SGL_(ipc_columns);
+static EventColumns*   curr_columns;
+static EvTag*          curr_tag_slot;
+static PrismMemSlot*   curr_mem_slot;
+static PrismCompSlot*  curr_comp_slot;
+static PrismCxtSlot*   curr_cxt_slot;
+static PrismSyncSlot*  curr_sync_slot;
+/* cached column encoding state */
+
+
+Bool SGL_(ipc_compact);
+static PrismEncoder    curr_encoder;
+/* cached compact encoding state */
+
+
+static UInt buffer_count;
+static UInt event_capacity;
+static UInt name_capacity;
+/* buffer configuration chosen by Prism, see PrismIPCHeader */
+
+static Bool* is_full;
 /* track available buffers */
 
 
+static UInt transport;
+static UInt produced;
+/* futex transport: buffers filled so far,
+ * see PrismIPCHeader in CommonShmemIPC.h */
+
+
+typedef struct IPCChannel
+{
+    Int                 emptyfd;
+    Int                 fullfd;
+    PrismDBISharedData* shmem;
+    UInt                produced;
+    Bool                is_full[PRISM_IPC_MAX_BUFFERS];
+
+    UInt                curr_idx;
+    EventBuffer*        curr_ev_buf;
+    PrismEvVariant*     curr_ev_slot;
+    NameBuffer*         curr_name_buf;
+    char*               curr_name_slot;
+    EventColumns*       curr_columns;
+    EvTag*              curr_tag_slot;
+    PrismMemSlot*       curr_mem_slot;
+    PrismCompSlot*      curr_comp_slot;
+    PrismCxtSlot*       curr_cxt_slot;
+    PrismSyncSlot*      curr_sync_slot;
+    PrismEncoder        curr_encoder;
+} IPCChannel;
+
+static IPCChannel channels[PRISM_IPC_MAX_CHANNELS];
+static UInt channel_count;
+static UInt curr_channel;
+/* Prism may open several channels, one per backend thread.
+ * The state above is cached for the current channel and
+ * saved here while another channel is current */
+
+
+static inline SysRes futex(UInt *addr, Int op, UInt val, struct vki_timespec *timeout)
+{
+    return VG_(do_syscall6)(__NR_futex, (UWord)addr, op, val, (UWord)timeout, 0, 0);
+}
+
+
+static void check_prism_alive(void)
+{
+    /* Prism keeps its end of the 'empty' fifo open until
+     * the event stream is finished */
+    struct vki_pollfd pfd;
+    pfd.fd      = emptyfd;
+    pfd.events  = VKI_POLLIN;
+    pfd.revents = 0;
+    if (VG_(poll)(&pfd, 1, 0) > 0 && (pfd.revents & VKI_POLLHUP))
+    {
+        VG_(umsg)("Prism disconnected unexpectedly\n");
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+}
+
+
+static void wait_for_empty_buffer(void)
+{
+    /* Block only if every buffer is still waiting to be consumed by Prism */
+    PrismIPCHeader *header = &shmem->header;
+    struct vki_timespec timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_nsec = PRISM_IPC_FUTEX_TIMEOUT_NS;
+
+    UInt consumed = __atomic_load_n(&header->consumed, __ATOMIC_ACQUIRE);
+    while (produced - consumed >= buffer_count)
+    {
+        __atomic_store_n(&header->producerWaiting, 1, __ATOMIC_SEQ_CST);
+        consumed = __atomic_load_n(&header->consumed, __ATOMIC_SEQ_CST);
+        if (produced - consumed >= buffer_count)
+        {
+            SysRes res = futex(&header->consumed, VKI_FUTEX_WAIT, consumed, &timeout);
+            if (sr_isError(res) && sr_Err(res) == VKI_ETIMEDOUT)
+                check_prism_alive();
+        }
+        __atomic_store_n(&header->producerWaiting, 0, __ATOMIC_SEQ_CST);
+        consumed = __atomic_load_n(&header->consumed, __ATOMIC_ACQUIRE);
+    }
+}
+
+
 static inline void set_and_init_buffer(UInt buf_idx)
 {
-    curr_ev_buf = shmem->eventBuffers + buf_idx;
-    curr_ev_buf->used = 0;
-    curr_ev_slot = curr_ev_buf->events + curr_ev_buf->used;
+    curr_ev_buf = prismIPCEventBuffer(&shmem->header, buf_idx);
+    if (SGL_(ipc_columns) == True)
+    {
+        /* Prism already set the encoding and capacity */
+        prismColumnsReset(curr_ev_buf);
+        curr_columns   = prismColumns(curr_ev_buf);
+        curr_tag_slot  = prismColumnTags(curr_ev_buf);
+        curr_mem_slot  = prismColumnMem(curr_ev_buf);
+        curr_comp_slot = prismColumnComp(curr_ev_buf);
+        curr_cxt_slot  = prismColumnCxt(curr_ev_buf);
+        curr_sync_slot = prismColumnSync(curr_ev_buf);
+    }
+    else if (SGL_(ipc_compact) == True)
+    {
+        prismEncoderInit(&curr_encoder, curr_ev_buf);
+    }
+    else
+    {
+        curr_ev_buf->used = 0;
+        curr_ev_slot = curr_ev_buf->events + curr_ev_buf->used;
+    }
 
-    curr_name_buf = shmem->nameBuffers + buf_idx;
+    curr_name_buf = prismIPCNameBuffer(&shmem->header, buf_idx);
     curr_name_buf->used = 0;
     curr_name_slot = curr_name_buf->names + curr_name_buf->used;
 }
 
 
+static inline void finish_buffer(void)
+{
+    /* compact events are only readable once their length is published */
+    if (SGL_(ipc_compact) == True)
+        prismEncoderFinish(&curr_encoder);
+}
+
+
 static inline void flush_to_prism(void)
 {
+    finish_buffer();
+
+    if (transport == PRISM_IPC_TRANSPORT_FUTEX)
+    {
+        /* Publish the buffer, and only wake Prism
+         * if it ran out of full buffers */
+        PrismIPCHeader *header = &shmem->header;
+        __atomic_store_n(&header->produced, ++produced, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&header->consumerWaiting, __ATOMIC_SEQ_CST) != 0)
+            futex(&header->produced, VKI_FUTEX_WAKE, 1, NULL);
+        return;
+    }
+
     /* Mark that the buffer is being flushed,
      * and tell Prism the buffer is ready to consume */
     is_full[curr_idx] = True;
@@ -57,12 +200,17 @@ static inline void set_next_buffer(void)
 {
     /* try the next buffer, circular */
     ++curr_idx;
-    if (curr_idx == PRISM_IPC_BUFFERS)
+    if (curr_idx == buffer_count)
         curr_idx = 0;
 
     /* if the next buffer is full,
      * wait until Prism communicates that it's free */
-    if (is_full[curr_idx])
+    if (transport == PRISM_IPC_TRANSPORT_FUTEX)
+    {
+        wait_for_empty_buffer();
+        tl_assert(produced % buffer_count == curr_idx);
+    }
+    else if (is_full[curr_idx])
     {
         UInt buf_idx;
         Int res = VG_(read)(emptyfd, &buf_idx, sizeof(buf_idx));
@@ -74,7 +222,7 @@ static inline void set_next_buffer(void)
             VG_(exit)(1);
         }
 
-        tl_assert(buf_idx < PRISM_IPC_BUFFERS);
+        tl_assert(buf_idx < buffer_count);
         tl_assert(buf_idx == curr_idx);
         curr_idx = buf_idx;
         is_full[curr_idx] = False;
@@ -86,13 +234,16 @@ static inline void set_next_buffer(void)
 
 static inline Bool is_events_full(void)
 {
-    return curr_ev_buf->used == PRISM_EVENTS_BUFFER_SIZE;
+    /* a compact buffer is full when the next event might not fit */
+    if (SGL_(ipc_compact) == True)
+        return prismEncoderFull(&curr_encoder) ? True : False;
+    return curr_ev_buf->used == event_capacity;
 }
 
 
 static inline Bool is_names_full(UInt size)
 {
-    return (curr_name_buf->used + size) > PRISM_EVENTS_BUFFER_SIZE;
+    return (curr_name_buf->used + size) > name_capacity;
 }
 
 
@@ -131,6 +282,176 @@ EventNameSlotTuple SGL_(acq_event_name_slot)(UInt size)
 }
 
 
+/* Column encoding
+ * Every column has room for the buffer's full event capacity,
+ * so only the total number of events needs to be checked */
+static inline void reserve_column_slot(void)
+{
+    tl_assert(initialized == True);
+    tl_assert(SGL_(ipc_columns) == True);
+
+    if (is_events_full())
+    {
+        flush_to_prism();
+        set_next_buffer();
+    }
+
+    curr_ev_buf->used++;
+}
+
+
+PrismMemSlot* SGL_(acq_mem_slot)()
+{
+    reserve_column_slot();
+    *curr_tag_slot++ = PRISM_MEM_TAG;
+    curr_columns->mem++;
+    return curr_mem_slot++;
+}
+
+
+PrismCompSlot* SGL_(acq_comp_slot)()
+{
+    reserve_column_slot();
+    *curr_tag_slot++ = PRISM_COMP_TAG;
+    curr_columns->comp++;
+    return curr_comp_slot++;
+}
+
+
+PrismCxtSlot* SGL_(acq_cxt_slot)()
+{
+    reserve_column_slot();
+    *curr_tag_slot++ = PRISM_CXT_TAG;
+    curr_columns->cxt++;
+    return curr_cxt_slot++;
+}
+
+
+PrismSyncSlot* SGL_(acq_sync_slot)()
+{
+    reserve_column_slot();
+    *curr_tag_slot++ = PRISM_SYNC_TAG;
+    curr_columns->sync++;
+    return curr_sync_slot++;
+}
+
+
+CxtNameSlotTuple SGL_(acq_cxt_name_slot)(UInt size)
+{
+    tl_assert(initialized == True);
+
+    /* flush both buffers together, like SGL_(acq_event_name_slot) */
+    if (is_names_full(size))
+    {
+        flush_to_prism();
+        set_next_buffer();
+    }
+
+    PrismCxtSlot *slot = SGL_(acq_cxt_slot)();
+    CxtNameSlotTuple tuple = {slot, curr_name_slot, curr_name_buf->used};
+    curr_name_buf->used += size;
+    curr_name_slot      += size;
+
+    return tuple;
+}
+
+
+/* Compact encoding
+ * The encoder counts the events it writes */
+PrismEncoder* SGL_(acq_encoder)()
+{
+    tl_assert(initialized == True);
+    tl_assert(SGL_(ipc_compact) == True);
+
+    if (is_events_full())
+    {
+        flush_to_prism();
+        set_next_buffer();
+    }
+
+    return &curr_encoder;
+}
+
+
+EncoderNameSlotTuple SGL_(acq_encoder_name_slot)(UInt size)
+{
+    tl_assert(initialized == True);
+    tl_assert(SGL_(ipc_compact) == True);
+
+    if (is_events_full() || is_names_full(size))
+    {
+        flush_to_prism();
+        set_next_buffer();
+    }
+
+    EncoderNameSlotTuple tuple = {&curr_encoder, curr_name_slot, curr_name_buf->used};
+    curr_name_buf->used += size;
+    curr_name_slot      += size;
+
+    return tuple;
+}
+
+
+/* Channels
+ * Guest threads are spread over the channels by thread id */
+static void save_channel(IPCChannel *ch)
+{
+    ch->emptyfd        = emptyfd;
+    ch->fullfd         = fullfd;
+    ch->shmem          = shmem;
+    ch->produced       = produced;
+    ch->curr_idx       = curr_idx;
+    ch->curr_ev_buf    = curr_ev_buf;
+    ch->curr_ev_slot   = curr_ev_slot;
+    ch->curr_name_buf  = curr_name_buf;
+    ch->curr_name_slot = curr_name_slot;
+    ch->curr_columns   = curr_columns;
+    ch->curr_tag_slot  = curr_tag_slot;
+    ch->curr_mem_slot  = curr_mem_slot;
+    ch->curr_comp_slot = curr_comp_slot;
+    ch->curr_cxt_slot  = curr_cxt_slot;
+    ch->curr_sync_slot = curr_sync_slot;
+    ch->curr_encoder   = curr_encoder;
+}
+
+
+static void load_channel(IPCChannel *ch)
+{
+    emptyfd        = ch->emptyfd;
+    fullfd         = ch->fullfd;
+    shmem          = ch->shmem;
+    produced       = ch->produced;
+    is_full        = ch->is_full;
+    curr_idx       = ch->curr_idx;
+    curr_ev_buf    = ch->curr_ev_buf;
+    curr_ev_slot   = ch->curr_ev_slot;
+    curr_name_buf  = ch->curr_name_buf;
+    curr_name_slot = ch->curr_name_slot;
+    curr_columns   = ch->curr_columns;
+    curr_tag_slot  = ch->curr_tag_slot;
+    curr_mem_slot  = ch->curr_mem_slot;
+    curr_comp_slot = ch->curr_comp_slot;
+    curr_cxt_slot  = ch->curr_cxt_slot;
+    curr_sync_slot = ch->curr_sync_slot;
+    curr_encoder   = ch->curr_encoder;
+}
+
+
+void SGL_(ipc_switch_thread)(ThreadId tid)
+{
+    if (channel_count <= 1)
+        return;
+
+    UInt channel = tid % channel_count;
+    if (channel == curr_channel)
+        return;
+
+    save_channel(&channels[curr_channel]);
+    curr_channel = channel;
+    load_channel(&channels[curr_channel]);
+}
+
+
 /******************************
  * Initialization/Termination
  ******************************/
@@ -185,7 +506,17 @@ static PrismDBISharedData* open_shmem(const HChar *shmem_path, int flags)
         VG_(exit)(1);
     }
 
-    SysRes res = VG_(am_shared_mmap_file_float_valgrind)(sizeof(PrismDBISharedData),
+    /* Prism sizes the file to fit the buffer configuration
+     * it wrote into the header */
+    Long shared_mem_size = VG_(fsize)(shared_mem_fd);
+    if (shared_mem_size < (Long)sizeof(PrismDBISharedData))
+    {
+        VG_(umsg)("Shared_mem file %s is too small\n", shmem_path);
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    SysRes res = VG_(am_shared_mmap_file_float_valgrind)(shared_mem_size,
                                                          VKI_PROT_READ|VKI_PROT_WRITE,
                                                          shared_mem_fd, (Off64T)0);
     if (sr_isError(res))
@@ -199,57 +530,115 @@ static PrismDBISharedData* open_shmem(const HChar *shmem_path, int flags)
     Addr addr_shared = sr_Res (res);
     VG_(close)(shared_mem_fd);
 
-    return (PrismDBISharedData*) addr_shared;
+    PrismDBISharedData *shared = (PrismDBISharedData*) addr_shared;
+    if (shared->header.totalSize > (ULong)shared_mem_size)
+    {
+        VG_(umsg)("Shared_mem file %s does not match its header\n", shmem_path);
+        VG_(umsg)("Cannot recover from previous error. Good-bye.\n");
+        VG_(exit)(1);
+    }
+
+    return shared;
 }
 
 
-void SGL_(init_IPC)()
+static void open_channel(UInt channel)
 {
-    tl_assert(initialized == False);
-
-    if (SGL_(clo).ipc_dir == NULL)
-    {
-       VG_(fmsg)("No --ipc-dir argument found, shutting down...\n");
-       VG_(exit)(1);
-    }
-
+    /* Connect to one channel and make it the current channel */
     Int ipc_dir_len = VG_(strlen)(SGL_(clo).ipc_dir);
     Int filename_len;
 
-    //len is strlen + null + other chars (/ and -0)
-    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_SHMEM_BASENAME) + 4;
+    //len is strlen + null + other chars (/ and -N)
+    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_SHMEM_BASENAME) + 16;
     HChar shmem_path[filename_len];
-    VG_(snprintf)(shmem_path, filename_len, "%s/%s-0", SGL_(clo).ipc_dir, PRISM_IPC_SHMEM_BASENAME);
+    VG_(snprintf)(shmem_path, filename_len, "%s/%s-%u", SGL_(clo).ipc_dir, PRISM_IPC_SHMEM_BASENAME, channel);
 
-    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_EMPTYFIFO_BASENAME) + 4;
+    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_EMPTYFIFO_BASENAME) + 16;
     HChar emptyfifo_path[filename_len];
-    VG_(snprintf)(emptyfifo_path, filename_len, "%s/%s-0", SGL_(clo).ipc_dir, PRISM_IPC_EMPTYFIFO_BASENAME);
+    VG_(snprintf)(emptyfifo_path, filename_len, "%s/%s-%u", SGL_(clo).ipc_dir, PRISM_IPC_EMPTYFIFO_BASENAME, channel);
 
-    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_FULLFIFO_BASENAME) + 4;
+    filename_len = ipc_dir_len + VG_(strlen)(PRISM_IPC_FULLFIFO_BASENAME) + 16;
     HChar fullfifo_path[filename_len];
-    VG_(snprintf)(fullfifo_path, filename_len, "%s/%s-0", SGL_(clo).ipc_dir, PRISM_IPC_FULLFIFO_BASENAME);
+    VG_(snprintf)(fullfifo_path, filename_len, "%s/%s-%u", SGL_(clo).ipc_dir, PRISM_IPC_FULLFIFO_BASENAME, channel);
 
     emptyfd = open_fifo(emptyfifo_path, VKI_O_RDONLY);
     fullfd  = open_fifo(fullfifo_path, VKI_O_WRONLY);
     shmem   = open_shmem(shmem_path, VKI_O_RDWR);
+    tl_assert(shmem->header.channel == channel);
 
-    /* initialize cached IPC state */
+    curr_channel = channel;
+    is_full = channels[channel].is_full;
+    for (UInt i=0; i<PRISM_IPC_MAX_BUFFERS; ++i)
+        is_full[i] = False;
+    produced = 0;
     curr_idx = 0;
+}
+
+
+void SGL_(init_IPC)()
+{
+    tl_assert(initialized == False);
+
+    if (SGL_(clo).ipc_dir == NULL)
+    {
+       VG_(fmsg)("No --ipc-dir argument found, shutting down...\n");
+       VG_(exit)(1);
+    }
+
+    open_channel(0);
+
+    /* initialize cached IPC state */
+    transport = shmem->header.transport;
+    tl_assert(transport == PRISM_IPC_TRANSPORT_FIFO ||
+              transport == PRISM_IPC_TRANSPORT_FUTEX);
+    buffer_count   = shmem->header.bufferCount;
+    event_capacity = shmem->header.eventCapacity;
+    name_capacity  = shmem->header.nameCapacity;
+    channel_count  = shmem->header.channelCount;
+    tl_assert(buffer_count >= 2 && buffer_count <= PRISM_IPC_MAX_BUFFERS);
+    tl_assert((buffer_count & (buffer_count - 1)) == 0);
+    tl_assert(event_capacity > 0);
+    tl_assert(channel_count >= 1 && channel_count <= PRISM_IPC_MAX_CHANNELS);
+    tl_assert(shmem->header.encoding == PRISM_EVENTS_PACKED ||
+              shmem->header.encoding == PRISM_EVENTS_COLUMNS ||
+              shmem->header.encoding == PRISM_EVENTS_COMPACT);
+    SGL_(ipc_columns) = (shmem->header.encoding == PRISM_EVENTS_COLUMNS);
+    SGL_(ipc_compact) = (shmem->header.encoding == PRISM_EVENTS_COMPACT);
     set_and_init_buffer(curr_idx);
-    for (UInt i=0; i<PRISM_IPC_BUFFERS; ++i)
-        is_full[i] = False;
+
+    /* Prism opens every channel with the same configuration */
+    const UInt encoding = shmem->header.encoding;
+    for (UInt i=1; i<channel_count; ++i)
+    {
+        save_channel(&channels[curr_channel]);
+        open_channel(i);
+        tl_assert(shmem->header.transport     == transport &&
+                  shmem->header.encoding      == encoding &&
+                  shmem->header.bufferCount   == buffer_count &&
+                  shmem->header.eventCapacity == event_capacity &&
+                  shmem->header.nameCapacity  == name_capacity);
+        set_and_init_buffer(curr_idx);
+    }
+    save_channel(&channels[curr_channel]);
+    curr_channel = 0;
+    load_channel(&channels[curr_channel]);
 
     initialized = True;
 }
 
 
-void SGL_(term_IPC)(void)
+static void term_channel(void)
 {
-    tl_assert(initialized == True);
-
     /* send finish sequence */
     UInt finished = PRISM_IPC_FINISHED;
-    if (VG_(write)(fullfd, &curr_idx, sizeof(curr_idx)) != sizeof(curr_idx) ||
+    finish_buffer();
+    if (transport == PRISM_IPC_TRANSPORT_FUTEX)
+    {
+        flush_to_prism();
+        __atomic_store_n(&shmem->header.finished, 1, __ATOMIC_SEQ_CST);
+        futex(&shmem->header.produced, VKI_FUTEX_WAKE, 1, NULL);
+    }
+    else if (VG_(write)(fullfd, &curr_idx, sizeof(curr_idx)) != sizeof(curr_idx) ||
         VG_(write)(fullfd, &finished, sizeof(finished)) != sizeof(finished))
     {
         VG_(umsg)("error VG_(write)\n");
@@ -264,3 +653,17 @@ void SGL_(term_IPC)(void)
     VG_(close)(emptyfd);
     VG_(close)(fullfd);
 }
+
+
+void SGL_(term_IPC)(void)
+{
+    tl_assert(initialized == True);
+
+    save_channel(&channels[curr_channel]);
+    for (UInt i=0; i<channel_count; ++i)
+    {
+        curr_channel = i;
+        load_channel(&channels[curr_channel]);
+        term_channel();
+    }
+}
@@ -2,6 +2,7 @@
 #define SGL_IPC_H
 
 #include "Frontends/CommonShmemIPC.h"
+#include "Core/EventCodec.h"
 #include "global.h"
 
 /* An implementation of interprocess communication with the Sigil2 frontend.
@@ -18,6 +19,11 @@ typedef struct EventNameSlotTuple
 void SGL_(init_IPC)(void);
 void SGL_(term_IPC)(void);
 
+void SGL_(ipc_switch_thread)(ThreadId tid);
+/* Send the following events to the channel for thread 'tid'.
+ * With more than one channel (one per Prism backend thread),
+ * each guest thread always uses the same channel */
+
 PrismEvVariant* SGL_(acq_event_slot)(void);
 /* Get a buffer slot to add an event */
 
@@ -25,4 +31,39 @@ EventNameSlotTuple SGL_(acq_event_name_slot)(UInt size);
 /* Get a buffer slot to add an event (probably a context event)
  * and a name slot to add a name with it (like a function name) */
 
+
+typedef struct CxtNameSlotTuple
+{
+    PrismCxtSlot*  cxt_slot;
+    char*          name_slot;
+    UInt           name_idx;
+} CxtNameSlotTuple;
+
+extern Bool SGL_(ipc_columns);
+/* True if Prism asked for the column encoding (PRISM_EVENTS_COLUMNS).
+ * Events must then be added through the typed slots below,
+ * which also record the event's tag */
+
+PrismMemSlot*  SGL_(acq_mem_slot)(void);
+PrismCompSlot* SGL_(acq_comp_slot)(void);
+PrismCxtSlot*  SGL_(acq_cxt_slot)(void);
+PrismSyncSlot* SGL_(acq_sync_slot)(void);
+CxtNameSlotTuple SGL_(acq_cxt_name_slot)(UInt size);
+
+
+typedef struct EncoderNameSlotTuple
+{
+    PrismEncoder*  encoder;
+    char*          name_slot;
+    UInt           name_idx;
+} EncoderNameSlotTuple;
+
+extern Bool SGL_(ipc_compact);
+/* True if Prism asked for the compact encoding (PRISM_EVENTS_COMPACT).
+ * Events must then be written with the prismEncode*() functions
+ * in EventCodec.h, one event per acquired encoder */
+
+PrismEncoder* SGL_(acq_encoder)(void);
+EncoderNameSlotTuple SGL_(acq_encoder_name_slot)(UInt size);
+
 #endif
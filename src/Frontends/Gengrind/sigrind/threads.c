@@ -27,6 +27,7 @@
 */
 
 #include "log_events.h"
+#include "sigil2_ipc.h"
 #include "global.h"
 #include "Core/PrimitiveEnums.h"
 
@@ -135,11 +136,12 @@ void SGL_(switch_thread)(ThreadId tid)
     return;
 
   SGL_(active_tid) = tid;
+  SGL_(ipc_switch_thread)(tid);
 
   /* ML: always send thread switch events; 
    * valgrind can change at any time, even if sigrind is 'inside' 
    * a synchronization call or outside the function being collected */ 
-  SGL_(log_sync)(PRISM_SYNC_SWAP, SGL_(active_tid), UNUSED_SYNC_DATA);
+  SGL_(log_swap)();
 }
 
 void CLG_(switch_thread)(ThreadId tid)
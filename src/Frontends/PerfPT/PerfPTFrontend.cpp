@@ -37,13 +37,15 @@ auto perfPTCapabilities() -> prism::capabilities
 };
 
 #ifndef PERF_ENABLE
-auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                 IpcConfig ipc)
     -> FrontendIfaceGenerator
 {
     (void)execArgs;
     (void)feArgs;
     (void)threads;
     (void)reqs;
+    (void)ipc;
     PrismLog::fatal("Perf frontend not available");
 }
 #else
@@ -163,12 +165,15 @@ auto configureIpcDir() -> std::string
 //-----------------------------------------------------------------------------
 /** Interface to Prism core **/
 
-auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                 IpcConfig ipc)
     -> FrontendIfaceGenerator
 {
     //TODO add command line switches for perf to handle capabilities
     if (threads != 1)
         fatal("Perf frontend attempted with other than 1 thread");
+    if (ipc.isDefault() == false)
+        fatal("Perf frontend only supports the default IPC transport, encoding and buffer sizes");
     auto ipcDir = configureIpcDir();
     Cleanup::setCleanupDir(ipcDir);
 
@@ -186,7 +191,7 @@ auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabiliti
     else
         fatal(std::string("perf fork failed -- ") + strerror(errno));
 
-    return [=]{ return std::make_unique<ShmemFrontend<PrismPerfSharedData>>(ipcDir); };
+    return ShmemFrontend<PrismPerfSharedData>::generator(ipcDir, ipc, 1);
 }
 
 #endif // PERF_ENABLE
@@ -3,7 +3,8 @@
 
 #include "Core/Frontends.hpp"
 
-auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs)
+auto startPerfPT(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                 IpcConfig ipc)
     -> FrontendIfaceGenerator;
 auto perfPTCapabilities() -> prism::capabilities;
 
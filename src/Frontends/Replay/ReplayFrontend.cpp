@@ -0,0 +1,220 @@
+#include "Utils/PrismLog.hpp"
+#include "ReplayFrontend.hpp"
+#include "Core/Recording.hpp"
+#include "Core/EventCodec.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+auto replayCapabilities() -> prism::capabilities
+{
+    return prism::recordCapabilities();
+};
+
+using PrismLog::fatal;
+using PrismLog::info;
+using PrismLog::warn;
+
+namespace
+{
+
+auto recordingPath(const std::string &dir, unsigned stream) -> std::string
+{
+    return dir + "/" + prism::recordFilePrefix + std::to_string(stream);
+}
+
+
+class ReplayFrontend : public FrontendIface
+{
+    /* Maps a recording and hands its buffers to the backend in place.
+     * The mapping is private, so the file is never modified.
+     * Compact buffers are decoded into a scratch buffer first.
+     * Names are copied into a full size arena, because consumers,
+     * e.g. staging, may read all PRISM_NAMES_BUFFER_SIZE bytes of it */
+
+  public:
+    ReplayFrontend(const std::string &path, unsigned long long skip, unsigned long long count)
+        : path(path)
+        , names(PRISM_NAMES_BUFFER_SIZE)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            fatal("replay: could not open " + path + " -- " + strerror(errno));
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+            fatal("replay: could not stat " + path + " -- " + strerror(errno));
+        size = info.st_size;
+        if (size < sizeof(prism::RecordHeader) + sizeof(prism::RecordFooter))
+            corrupt();
+
+        void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            fatal("replay: could not map " + path + " -- " + strerror(errno));
+        base = static_cast<char*>(map);
+        madvise(base, size, MADV_SEQUENTIAL);
+
+        auto header = reinterpret_cast<const prism::RecordHeader*>(base);
+        if (std::memcmp(header->magic, prism::recordMagic, sizeof(header->magic)) != 0 ||
+            header->version != prism::recordVersion)
+            fatal("replay: not a recording, or from another version of prism: " + path);
+
+        auto footer = reinterpret_cast<const prism::RecordFooter*>(base + size - sizeof(prism::RecordFooter));
+        if (std::memcmp(footer->magic, prism::recordMagic, sizeof(footer->magic)) != 0)
+            fatal("replay: incomplete recording: " + path);
+        if (footer->indexOffset < sizeof(prism::RecordHeader) ||
+            footer->blocks != (size - sizeof(prism::RecordFooter) - footer->indexOffset) / sizeof(uint64_t))
+            corrupt();
+
+        index = reinterpret_cast<const uint64_t*>(base + footer->indexOffset);
+        blocksEnd = footer->indexOffset;
+        next = std::min<unsigned long long>(skip, footer->blocks);
+        last = std::min<unsigned long long>(footer->blocks - next, count) + next;
+
+        FrontendIface::nameBase = [&]{ return names.data(); };
+    }
+
+    ~ReplayFrontend() override
+    {
+        munmap(base, size);
+        info("replay     : {} events in {} buffers from {}", events, buffers, path);
+    }
+
+    virtual auto acquireBuffer() -> EventBufferPtr override final
+    {
+        if (next == last)
+            return nullptr;
+
+        auto offset = index[next++];
+        if (offset < sizeof(prism::RecordHeader) || offset + sizeof(prism::RecordBlock) > blocksEnd)
+            corrupt();
+
+        auto block = reinterpret_cast<const prism::RecordBlock*>(base + offset);
+        auto image = offset + sizeof(prism::RecordBlock);
+        auto nameOffset = image + prism::recordPadded(block->eventBytes);
+        if (block->eventBytes < sizeof(EventBuffer) || nameOffset + block->nameBytes > blocksEnd ||
+            block->nameBytes > names.size())
+            corrupt();
+
+        auto buf = reinterpret_cast<EventBuffer*>(base + image);
+        if (block->eventBytes != prismEventBufferSize(buf->encoding, buf->capacity))
+            corrupt();
+        std::memcpy(names.data(), base + nameOffset, block->nameBytes);
+
+        if (buf->encoding == PRISM_EVENTS_COMPACT)
+            buf = decode(buf);
+        else if (buf->encoding != PRISM_EVENTS_PACKED || buf->used > buf->capacity)
+            corrupt();
+
+        events += buf->used;
+        ++buffers;
+        return EventBufferPtr(buf);
+    }
+
+    virtual auto releaseBuffer(EventBufferPtr buf) -> void override final
+    {
+        buf.release();
+    }
+
+  private:
+    auto decode(const EventBuffer *buf) -> EventBuffer*
+    {
+        /* every event takes at least one byte */
+        if (buf->used > prismCompactCapacity(buf))
+            corrupt();
+
+        decoded.resize(prismEventBufferSize(PRISM_EVENTS_PACKED, buf->used));
+        auto packed = reinterpret_cast<EventBuffer*>(decoded.data());
+        if (prismDecodeCompact(buf, packed) == 0)
+            corrupt();
+
+        return packed;
+    }
+
+    [[noreturn]] auto corrupt() -> void
+    {
+        fatal("replay: corrupt recording: " + path);
+    }
+
+    const std::string path;
+    char *base{nullptr};
+    size_t size{0};
+
+    const uint64_t *index{nullptr};
+    uint64_t blocksEnd{0};
+    unsigned long long next{0}, last{0};
+    std::vector<char> names;
+    std::vector<char> decoded;
+
+    unsigned long long events{0};
+    unsigned long long buffers{0};
+    /* statistics */
+};
+
+
+auto parseCount(const std::string &arg, const char *name) -> unsigned long long
+{
+    try
+    {
+        size_t end;
+        auto ret = std::stoull(arg, &end);
+        if (end != arg.size())
+            fatal("replay {}: invalid argument: {}", name, arg);
+        return ret;
+    }
+    catch (std::exception &e)
+    {
+        fatal("replay {}: invalid argument: {}", name, arg);
+    }
+}
+
+}; //end namespace
+
+
+auto startReplay(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                 IpcConfig ipc)
+    -> FrontendIfaceGenerator
+{
+    /* The executable is the directory the 'record' backend wrote to.
+     * Each backend thread replays one recorded stream */
+    (void)reqs;
+    (void)ipc;
+
+    if (execArgs.size() != 1)
+        fatal("replay frontend takes one option: the recording directory");
+    auto dir = execArgs.front();
+
+    /* -s SKIP_BUFFERS
+     * -n MAX_BUFFERS */
+    unsigned long long skip = 0;
+    unsigned long long count = ULLONG_MAX;
+    for (auto arg = feArgs.cbegin(); arg != feArgs.cend(); ++arg)
+    {
+        if ((*arg != "-s" && *arg != "-n") || arg + 1 == feArgs.cend())
+            fatal("unexpected replay frontend options");
+
+        auto opt = *arg;
+        auto val = parseCount(*(++arg), opt == "-s" ? "skip" : "count");
+        if (opt == "-s")
+            skip = val;
+        else
+            count = val;
+    }
+
+    struct stat info;
+    for (unsigned i = 0; i < threads; ++i)
+        if (stat(recordingPath(dir, i).c_str(), &info) != 0)
+            fatal("replay: no recording for thread {}: {}", i, recordingPath(dir, i));
+    if (stat(recordingPath(dir, threads).c_str(), &info) == 0)
+        warn("replay: {} holds more streams than threads, only replaying {}", dir, threads);
+
+    auto next = std::make_shared<std::atomic<unsigned>>(0);
+    return [=]{ unsigned stream = (*next)++;
+                return std::make_unique<ReplayFrontend>(recordingPath(dir, stream), skip, count); };
+}
@@ -0,0 +1,14 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "Core/Frontends.hpp"
+
+/* Feeds event streams recorded by the 'record' backend
+ * back to a backend, see Core/Recording.hpp */
+
+auto startReplay(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                 IpcConfig ipc)
+    -> FrontendIfaceGenerator;
+auto replayCapabilities() -> prism::capabilities;
+
+#endif
@@ -0,0 +1,455 @@
+#include "Utils/PrismLog.hpp"
+#include "SyntheticFrontend.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+
+auto syntheticCapabilities() -> prism::capabilities
+{
+    using namespace prism;
+    using namespace prism::capability;
+
+    auto caps = initCaps();
+
+    caps[MEMORY]         = availability::enabled;
+    caps[MEMORY_LDST]    = availability::enabled;
+    caps[MEMORY_SIZE]    = availability::enabled;
+    caps[MEMORY_ADDRESS] = availability::enabled;
+
+    caps[COMPUTE]              = availability::enabled;
+    caps[COMPUTE_INT_OR_FLOAT] = availability::enabled;
+    caps[COMPUTE_ARITY]        = availability::enabled;
+    caps[COMPUTE_OP]           = availability::enabled;
+    caps[COMPUTE_SIZE]         = availability::enabled;
+
+    caps[CONTROL_FLOW] = availability::nil;
+
+    caps[SYNC]      = availability::enabled;
+    caps[SYNC_TYPE] = availability::enabled;
+    caps[SYNC_ARGS] = availability::enabled;
+
+    caps[CONTEXT_INSTRUCTION] = availability::enabled;
+    caps[CONTEXT_BASIC_BLOCK] = availability::nil;
+    caps[CONTEXT_FUNCTION]    = availability::nil;
+    caps[CONTEXT_THREAD]      = availability::enabled;
+
+    return caps;
+};
+
+using PrismLog::fatal;
+using PrismLog::info;
+
+namespace
+{
+
+constexpr unsigned poolBuffers = 16;
+/* Events are generated once into a pool of this many buffers,
+ * which is then copied out over and over. Drawing every event from
+ * the distributions would make the frontend slower than the backends
+ * it is meant to measure. */
+
+constexpr PtrVal dataBase = 0x10000000;
+constexpr PtrVal codeBase = 0x400000;
+constexpr PtrVal codeSize = 1UL << 20;
+constexpr PtrVal lockBase = 0x1000;
+constexpr unsigned lockCount = 16;
+
+
+struct SyntheticConfig
+{
+    unsigned long long events{100000000};
+    /* per stream, including inserted thread swaps.
+     * Zero replays a dump exactly once */
+
+    unsigned mem{50}, comp{35}, sync{1}, cxt{14};
+    /* relative weight of each event type */
+
+    unsigned locality{90};
+    /* percent of memory accesses and instructions
+     * that follow on from the previous one */
+
+    PtrVal footprint{1UL << 24};
+    /* bytes of data touched */
+
+    unsigned threads{1};
+    unsigned long long swapPeriod{100000};
+    /* synthetic threads per stream, and the number
+     * of events between swaps to the next thread */
+
+    std::string dump;
+    /* replay this file instead of generating events */
+};
+
+
+//-----------------------------------------------------------------------------
+/** Option Parsing **/
+auto parseAll(const Args &args, const std::set<char> &options) -> std::map<char, std::string>
+{
+    std::map<char, std::string> matches;
+    for (auto arg = args.cbegin(); arg != args.cend(); ++arg)
+    {
+        if ((*arg).length() < 2 || (*arg)[0] != '-' || options.count((*arg)[1]) == 0)
+            fatal("unexpected synthetic frontend option: " + *arg);
+
+        char opt = (*arg)[1];
+        if ((*arg).length() > 2)
+            matches[opt] = (*arg).substr(2, std::string::npos);
+        else if (arg + 1 != args.cend())
+            matches[opt] = *(++arg);
+        else
+            fatal("synthetic frontend option missing argument: " + *arg);
+    }
+
+    return matches;
+}
+
+
+auto parseNumber(const std::string &arg, const char *name,
+                 unsigned long long min, unsigned long long max) -> unsigned long long
+{
+    try
+    {
+        size_t end;
+        auto ret = std::stoull(arg, &end);
+        if (end != arg.size() || ret < min || ret > max)
+            fatal("synthetic frontend {}: must be between {} and {}", name, min, max);
+        return ret;
+    }
+    catch (std::exception &e)
+    {
+        fatal("synthetic frontend {}: invalid argument: {}", name, arg);
+    }
+}
+
+
+auto parseMix(const std::string &arg, SyntheticConfig &config) -> void
+{
+    std::vector<unsigned> weights;
+    std::istringstream iss(arg);
+    std::string weight;
+    while (std::getline(iss, weight, ','))
+        weights.push_back(parseNumber(weight, "event mix", 0, 1000000));
+
+    if (weights.size() != 4)
+        fatal("synthetic frontend event mix: expected -m MEM,COMP,SYNC,CXT");
+
+    config.mem  = weights[0];
+    config.comp = weights[1];
+    config.sync = weights[2];
+    config.cxt  = weights[3];
+}
+
+
+auto parseConfig(const Args &args) -> SyntheticConfig
+{
+    std::set<char> options;
+    options.insert('n'); // -n EVENTS
+    options.insert('m'); // -m MEM,COMP,SYNC,CXT
+    options.insert('l'); // -l LOCALITY_PERCENT
+    options.insert('f'); // -f FOOTPRINT_BYTES
+    options.insert('t'); // -t THREADS
+    options.insert('s'); // -s SWAP_PERIOD
+    options.insert('r'); // -r DUMP_FILE
+    auto matches = parseAll(args, options);
+
+    SyntheticConfig config;
+    if (matches.count('r') > 0)
+    {
+        if (matches.size() > (matches.count('n') + 1))
+            fatal("synthetic frontend: -r only combines with -n");
+        config.dump = matches['r'];
+        config.events = 0;
+    }
+
+    if (matches.count('n') > 0)
+        config.events = parseNumber(matches['n'], "events", 1, ULLONG_MAX);
+    if (matches.count('m') > 0)
+        parseMix(matches['m'], config);
+    if (matches.count('l') > 0)
+        config.locality = parseNumber(matches['l'], "locality", 0, 100);
+    if (matches.count('f') > 0)
+        config.footprint = parseNumber(matches['f'], "footprint", 64, 1UL << 40);
+    if (matches.count('t') > 0)
+        config.threads = parseNumber(matches['t'], "threads", 1, 1024);
+    if (matches.count('s') > 0)
+        config.swapPeriod = parseNumber(matches['s'], "swap period", 0, ULLONG_MAX);
+
+    return config;
+}
+
+
+//-----------------------------------------------------------------------------
+/** Event Pools **/
+auto generatePool(const SyntheticConfig &config, const prism::capabilities &reqs,
+                  size_t size, uint64_t seed) -> std::vector<PrismEvVariant>
+{
+    using namespace prism::capability;
+
+    /* only generate what the backend asked for */
+    auto weight = [&](unsigned w, unsigned cap) { return reqs[cap] == availability::enabled ? w : 0u; };
+    std::vector<unsigned> weights{weight(config.mem, MEMORY), weight(config.comp, COMPUTE),
+                                  weight(config.sync, SYNC), weight(config.cxt, CONTEXT_INSTRUCTION)};
+    if (std::all_of(weights.begin(), weights.end(), [](unsigned w) { return w == 0; }))
+        fatal("synthetic frontend: no event types left to generate for this backend");
+
+    std::mt19937_64 rng(seed);
+    std::discrete_distribution<unsigned> kind(weights.begin(), weights.end());
+    std::uniform_int_distribution<unsigned> percent(0, 99);
+
+    const PtrVal words = config.footprint / sizeof(uint64_t);
+    PtrVal addr = dataBase;
+    PtrVal pc = codeBase;
+    PtrVal lock = 0;
+
+    std::vector<PrismEvVariant> pool(size);
+    for (auto &ev : pool)
+    {
+        std::memset(&ev, 0, sizeof(ev));
+        switch (kind(rng))
+        {
+        case 0:
+            if (percent(rng) < config.locality)
+                addr += sizeof(uint64_t);
+            else
+                addr = dataBase + (rng() % words) * sizeof(uint64_t);
+            if (addr >= dataBase + config.footprint)
+                addr = dataBase;
+
+            ev.tag = PRISM_MEM_TAG;
+            ev.mem.type = percent(rng) < 70 ? PRISM_MEM_LOAD : PRISM_MEM_STORE;
+            ev.mem.begin_addr = addr;
+            ev.mem.size = sizeof(uint64_t);
+            break;
+        case 1:
+            ev.tag = PRISM_COMP_TAG;
+            ev.comp.type = percent(rng) < 80 ? PRISM_COMP_IOP : PRISM_COMP_FLOP;
+            ev.comp.arity = PRISM_COMP_BINARY;
+            ev.comp.op = PRISM_COMP_ADD;
+            ev.comp.size = sizeof(uint64_t);
+            break;
+        case 2:
+            /* always in lock/unlock pairs */
+            ev.tag = PRISM_SYNC_TAG;
+            if (lock == 0)
+            {
+                lock = lockBase + (rng() % lockCount) * 64;
+                ev.sync.type = PRISM_SYNC_LOCK;
+                ev.sync.data[0] = lock;
+            }
+            else
+            {
+                ev.sync.type = PRISM_SYNC_UNLOCK;
+                ev.sync.data[0] = lock;
+                lock = 0;
+            }
+            break;
+        case 3:
+            if (percent(rng) < config.locality)
+                pc += 4;
+            else
+                pc = codeBase + (rng() % (codeSize / 4)) * 4;
+
+            ev.tag = PRISM_CXT_TAG;
+            ev.cxt.type = PRISM_CXT_INSTR;
+            ev.cxt.id = pc;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* the pool repeats, so it must not end with a lock held */
+    if (lock != 0)
+    {
+        auto &ev = pool.back();
+        std::memset(&ev, 0, sizeof(ev));
+        ev.tag = PRISM_SYNC_TAG;
+        ev.sync.type = PRISM_SYNC_UNLOCK;
+        ev.sync.data[0] = lock;
+    }
+
+    return pool;
+}
+
+
+auto loadDump(const std::string &path) -> std::vector<PrismEvVariant>
+{
+    /* A dump is the raw contents of packed EventBuffers,
+     * i.e. 'used' PrismEvVariants per buffer, back to back */
+
+    std::ifstream dump(path, std::ios::binary | std::ios::ate);
+    if (dump.good() == false)
+        fatal("could not read file: " + path);
+
+    auto bytes = static_cast<size_t>(dump.tellg());
+    if (bytes == 0 || bytes % sizeof(PrismEvVariant) != 0)
+        fatal("synthetic frontend: not an event dump: " + path);
+
+    std::vector<PrismEvVariant> pool(bytes / sizeof(PrismEvVariant));
+    dump.seekg(0);
+    dump.read(reinterpret_cast<char*>(pool.data()), bytes);
+    if (dump.good() == false)
+        fatal("could not read file: " + path);
+
+    for (const auto &ev : pool)
+    {
+        if (ev.tag < PRISM_MEM_TAG || ev.tag > PRISM_SYNC_TAG)
+            fatal("synthetic frontend: not an event dump: " + path);
+        if (ev.tag == PRISM_CXT_TAG &&
+            (ev.cxt.type == PRISM_CXT_FUNC_ENTER || ev.cxt.type == PRISM_CXT_FUNC_EXIT))
+            fatal("synthetic frontend: event dumps with function names are not supported");
+    }
+
+    return pool;
+}
+
+
+//-----------------------------------------------------------------------------
+/** Interface to Prism core **/
+class SyntheticFrontend : public FrontendIface
+{
+    /* Copies events out of the pool, wrapping around as needed,
+     * and inserts a swap to the next thread every 'swapPeriod' events */
+
+    using Pool = std::shared_ptr<const std::vector<PrismEvVariant>>;
+    using Clock = std::chrono::steady_clock;
+
+  public:
+    SyntheticFrontend(Pool pool, const SyntheticConfig &config, bool swaps,
+                      unsigned stream, unsigned capacity)
+        : pool(std::move(pool))
+        , remaining(config.events)
+        , swapPeriod(config.threads > 1 ? config.swapPeriod : 0)
+        , untilSwap(swaps ? 0 : ULLONG_MAX)
+        , firstThread(stream * config.threads + 1)
+        , threads(config.threads)
+        , capacity(capacity)
+        , storage(prismEventBufferSize(PRISM_EVENTS_PACKED, capacity))
+    {
+        assert(this->pool->empty() == false);
+    }
+
+    ~SyntheticFrontend() override
+    {
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        if (buffers > 0)
+            info("synthetic  : {} events in {} buffers, {:.1f} M events/s, {:.0f} MB/s",
+                 events, buffers, events / elapsed.count() / 1e6,
+                 events * sizeof(PrismEvVariant) / elapsed.count() / 1e6);
+    }
+
+    virtual auto acquireBuffer() -> EventBufferPtr override final
+    {
+        if (remaining == 0)
+            return nullptr;
+        if (buffers == 0)
+            start = Clock::now();
+
+        auto buf = reinterpret_cast<EventBuffer*>(storage.data());
+        buf->encoding = PRISM_EVENTS_PACKED;
+        buf->capacity = capacity;
+
+        size_t used = 0;
+        while (used < capacity && remaining > 0)
+        {
+            if (untilSwap == 0)
+            {
+                swap(buf->events[used++]);
+                --remaining;
+                continue;
+            }
+
+            auto n = std::min<unsigned long long>({capacity - used, remaining,
+                                                   pool->size() - cursor, untilSwap});
+            std::memcpy(&buf->events[used], pool->data() + cursor, n * sizeof(PrismEvVariant));
+            used += n;
+            remaining -= n;
+            untilSwap -= n;
+            cursor += n;
+            if (cursor == pool->size())
+                cursor = 0;
+        }
+
+        buf->used = used;
+        events += used;
+        ++buffers;
+        return EventBufferPtr(buf);
+    }
+
+    virtual auto releaseBuffer(EventBufferPtr buf) -> void override final
+    {
+        assert(buf.get() == reinterpret_cast<EventBuffer*>(storage.data()));
+        buf.release();
+    }
+
+  private:
+    auto swap(PrismEvVariant &ev) -> void
+    {
+        std::memset(&ev, 0, sizeof(ev));
+        ev.tag = PRISM_SYNC_TAG;
+        ev.sync.type = PRISM_SYNC_SWAP;
+        ev.sync.data[0] = firstThread + nextThread;
+
+        nextThread = (nextThread + 1) % threads;
+        untilSwap = swapPeriod > 0 ? swapPeriod : ULLONG_MAX;
+    }
+
+    const Pool pool;
+    size_t cursor{0};
+    unsigned long long remaining;
+
+    const unsigned long long swapPeriod;
+    unsigned long long untilSwap;
+    const SyncID firstThread;
+    const unsigned threads;
+    unsigned nextThread{0};
+
+    const unsigned capacity;
+    std::vector<char> storage;
+
+    unsigned long long events{0};
+    unsigned long long buffers{0};
+    Clock::time_point start;
+    /* statistics */
+};
+
+}; //end namespace
+
+
+auto startSynthetic(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                    IpcConfig ipc)
+    -> FrontendIfaceGenerator
+{
+    /* There is no program to run, so the executable is ignored.
+     * Each of the 'threads' streams generates its own events;
+     * only the buffer size is taken from the IPC settings */
+    (void)execArgs;
+    (void)threads;
+
+    auto config = parseConfig(feArgs);
+    auto capacity = ipc.bufferEvents;
+    auto next = std::make_shared<std::atomic<unsigned>>(0);
+
+    if (config.dump.empty() == false)
+    {
+        auto pool = std::make_shared<const std::vector<PrismEvVariant>>(loadDump(config.dump));
+        if (config.events == 0)
+            config.events = pool->size();
+
+        return [=]{ unsigned stream = (*next)++;
+                    return std::make_unique<SyntheticFrontend>(pool, config, false, stream, capacity); };
+    }
+
+    bool swaps = reqs[prism::capability::SYNC] == prism::capability::availability::enabled;
+    return [=]{ unsigned stream = (*next)++;
+                auto pool = generatePool(config, reqs, size_t{poolBuffers} * capacity, stream);
+                return std::make_unique<SyntheticFrontend>(
+                    std::make_shared<const std::vector<PrismEvVariant>>(std::move(pool)),
+                    config, swaps, stream, capacity); };
+}
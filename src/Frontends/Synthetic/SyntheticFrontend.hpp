@@ -0,0 +1,14 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include "Core/Frontends.hpp"
+
+/* Generates events inside Prism, without an external tool,
+ * to measure the throughput of the Prism core and the backends */
+
+auto startSynthetic(Args execArgs, Args feArgs, unsigned threads, prism::capabilities reqs,
+                    IpcConfig ipc)
+    -> FrontendIfaceGenerator;
+auto syntheticCapabilities() -> prism::capabilities;
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef SHADOWMEMORY_H
+#define SHADOWMEMORY_H
+
+#include "Core/Primitive.h" // PtrVal type
+#include "Utils/PrismLog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Shadow Memory tracks 'shadow state' for an address.
+ * For further clarification, please read,
+ * "How to Shadow Every Byte of Memory Used by a Program"
+ * by Nicholas Nethercote and Julian Seward
+ */
+
+using Addr = PtrVal;
+using PrismLog::fatal;
+using PrismLog::warn;
+
+/* Addresses are split into three levels: a top table, mid tables, and
+ * secondary maps of shadow objects, each allocated on first use.
+ * The default covers 57 bit addresses, i.e. 5-level paging; addresses past
+ * that have no shadow state, and are only counted.
+ *
+ * Recent secondary map translations are kept in a small direct-mapped
+ * cache of TLB_ENTRIES, so the common, local access skips the table walk.
+ * The cache belongs to the shadow memory, and is serialized with it.
+ *
+ * All tables are anonymous, NORESERVE mappings, so the kernel only
+ * commits the pages that get written, zero-filled on first touch.
+ * Shadow objects must be trivial, and all zero bits is their initial state.
+ *
+ * Tables are created on lookup, so a shadow memory is not thread safe;
+ * callers that share one between threads must serialize every access */
+template <typename SO, unsigned ADDR_BITS = 57, unsigned SM_BITS = 18,
+          unsigned TLB_ENTRIES = 16>
+class ShadowMemory
+{
+    static_assert(ADDR_BITS > SM_BITS && ADDR_BITS <= 64, "Invalid address range");
+    static_assert(SM_BITS > 0 && SM_BITS < 32, "Invalid secondary map size");
+    static_assert(TLB_ENTRIES > 0 && !(TLB_ENTRIES & (TLB_ENTRIES-1)),
+                  "TLB_ENTRIES must be a power of 2");
+    static_assert(sizeof(Addr)*CHAR_BIT >= ADDR_BITS, "Max address is too large for the platform");
+    static_assert(std::is_trivially_default_constructible<SO>::value &&
+                  std::is_trivially_destructible<SO>::value,
+                  "Shadow objects are zero-filled pages; their default must be all zero bits");
+
+    struct MidEntry
+    {
+        SO *map;
+        Addr id; /* index into maps, plus one */
+    };
+
+    struct TLBEntry
+    {
+        Addr idx{~0ULL}; /* secondary map index, i.e. addr >> SM_BITS */
+        SO *map{nullptr};
+    };
+
+  public:
+    ShadowMemory()
+        : addr_bits(ADDR_BITS)
+        , sm_bits(SM_BITS)
+        , mid_bits(std::min<Addr>(addr_bits - sm_bits, 18))
+        , top_bits(addr_bits - sm_bits - mid_bits)
+        , sm_size(1ULL << sm_bits)
+        , sm_bytes(sm_size * sizeof(SO))
+        , top(mapZeroed<MidEntry*>(1ULL << top_bits))
+    {}
+    ShadowMemory(const ShadowMemory &) = delete;
+    ShadowMemory &operator=(const ShadowMemory &) = delete;
+
+    ~ShadowMemory()
+    {
+        for (auto &m : maps)
+            munmap(m.first, sm_bytes);
+        for (Addr i = 0; i < (1ULL << top_bits); ++i)
+            if (top[i] != nullptr)
+                munmap(top[i], sizeof(MidEntry) << mid_bits);
+        munmap(top, sizeof(MidEntry*) << top_bits);
+    }
+
+    const Addr addr_bits;
+    const Addr sm_bits;
+    const Addr mid_bits;
+    const Addr top_bits;
+    const Addr sm_size;
+    const Addr sm_bytes;
+    /* Configuration */
+
+    auto operator[](Addr addr) -> SO&
+    {
+        /* an address past the shadowed range gets a scratch object,
+         * reset to the initial state on each access */
+        SO *map = secondary(addr);
+        if (map == nullptr)
+        {
+            scratch = SO();
+            return scratch;
+        }
+        return map[addr & (sm_size - 1)]; /* SM offset */
+    }
+
+    auto span(Addr addr, Addr bytes) -> std::pair<SO*, Addr>
+    {
+        /* The shadow objects for [addr, addr+bytes) are contiguous
+         * up to the end of the secondary map holding addr.
+         * Returns the first object and how many are in this map,
+         * so a range costs one lookup per secondary map it touches.
+         * The first object is null for addresses past the shadowed range */
+        Addr offset = addr & (sm_size - 1);
+        Addr count = std::min(bytes, sm_size - offset);
+        SO *map = secondary(addr);
+        return std::make_pair(map == nullptr ? nullptr : map + offset, count);
+    }
+
+    auto outOfRange() const -> Addr
+    {
+        /* lookups of addresses past the shadowed range */
+        return outOfRangeLookups;
+    }
+
+    auto tlbHits() const -> Addr { return lookups - tlbMisses; }
+    auto tlbHitRate() const -> double
+    {
+        /* fraction of lookups that skipped the table walk */
+        return lookups == 0 ? 0.0 : static_cast<double>(tlbHits()) / lookups;
+    }
+
+    auto mappedBytes() const -> Addr
+    {
+        /* address space reserved for secondary maps */
+        return maps.size() * sm_bytes;
+    }
+
+    auto touchedBytes() const -> Addr
+    {
+        /* pages of secondary maps that are resident, i.e. were written */
+        const Addr page = sysconf(_SC_PAGESIZE);
+        std::vector<unsigned char> resident((sm_bytes + page - 1) / page);
+
+        Addr touched = 0;
+        for (auto &m : maps)
+        {
+            if (mincore(m.first, sm_bytes, resident.data()) != 0)
+                continue;
+            for (auto r : resident)
+                touched += (r & 1) * page;
+        }
+        return touched;
+    }
+
+    template <typename F>
+    auto releaseCold(F &&onRelease) -> Addr
+    {
+        /* Returns the memory of each secondary map that was not looked up
+         * since the previous call back to the kernel; those maps revert to
+         * the initial state. onRelease(first, count) sees their objects
+         * first, to drop anything they refer to.
+         * Returns how many bytes of maps were released */
+        Addr released = 0;
+        for (auto &m : maps)
+        {
+            if (m.second == false)
+            {
+                onRelease(m.first, sm_size);
+                if (madvise(m.first, sm_bytes, MADV_DONTNEED) != 0)
+                    warn(std::string("shadow memory madvise failed -- ") + strerror(errno));
+                released += sm_bytes;
+            }
+            m.second = false;
+        }
+
+        /* the next lookup marks its map again */
+        tlb.fill(TLBEntry{});
+        return released;
+    }
+
+  private:
+    template <typename T>
+    static auto mapZeroed(Addr count) -> T*
+    {
+        void *p = mmap(nullptr, count * sizeof(T), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED)
+            fatal(std::string("shadow memory mmap failed -- ") + strerror(errno));
+        return static_cast<T*>(p);
+    }
+
+    auto secondary(Addr addr) -> SO*
+    {
+        /* Accesses are mostly to a few secondary maps, e.g. the stack,
+         * the heap, and globals; those hit in the TLB */
+        Addr idx = addr >> sm_bits;
+        TLBEntry &cached = tlb[idx & (TLB_ENTRIES - 1)];
+        ++lookups;
+        if (cached.idx == idx)
+            return cached.map;
+        ++tlbMisses;
+
+        if (addr_bits < 64 && (addr >> addr_bits) != 0)
+        {
+            ++outOfRangeLookups;
+            return nullptr;
+        }
+
+        MidEntry *&mid = top[idx >> mid_bits];
+        if (mid == nullptr)
+            mid = mapZeroed<MidEntry>(1ULL << mid_bits);
+
+        MidEntry &entry = mid[idx & ((1ULL << mid_bits) - 1)];
+        if (entry.map == nullptr)
+        {
+            entry.map = mapZeroed<SO>(sm_size);
+            maps.emplace_back(entry.map, true);
+            entry.id = maps.size();
+        }
+        maps[entry.id - 1].second = true;
+
+        cached.idx = idx;
+        cached.map = entry.map;
+        return entry.map;
+    }
+
+    MidEntry **top;
+    std::vector<std::pair<SO*, bool>> maps;
+    /* every secondary map, and if it was looked up since the last releaseCold() */
+
+    std::array<TLBEntry, TLB_ENTRIES> tlb;
+    Addr lookups{0};
+    Addr tlbMisses{0};
+
+    SO scratch;
+    Addr outOfRangeLookups{0};
+};
+
+#endif